@@ -0,0 +1,205 @@
+// Microbenchmarks for the server tick hot paths: Game::movePlayers (which
+// includes collision checking), Game::addPlayer spawn sampling, and full
+// snapshot serialization, swept over player count and grid size.
+// Reports ns/op and allocations/op so regressions in the tick path are
+// caught before a tournament night.
+#include "server/game_logic.h"
+#include "server/replay.h"
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <spdlog/spdlog.h>
+
+// Count every heap allocation so the harness can report allocations/op
+static std::atomic<std::size_t> g_allocations{0};
+
+void *operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using cycles::Direction;
+using cycles::Id;
+using cycles_server::Configuration;
+using cycles_server::Game;
+
+Configuration makeConfig(int gridWidth, int gridHeight) {
+  // Nonexistent path: the constructor falls back to defaults, which we then
+  // override field by field for the sweep
+  Configuration conf("/nonexistent/bench-config.yaml");
+  conf.gridWidth = gridWidth;
+  conf.gridHeight = gridHeight;
+  conf.maxClients = 60;
+  return conf;
+}
+
+void report(const std::string &name, std::size_t ops, double totalNs,
+            std::size_t allocations) {
+  std::printf("%-48s %12.1f ns/op %10.2f allocs/op  (%zu ops)\n", name.c_str(),
+              totalNs / ops, static_cast<double>(allocations) / ops, ops);
+}
+
+// Steer every player towards its first free neighbouring cell, so the
+// synthetic match keeps players alive and tails growing
+std::map<Id, Direction> pickDirections(Game &game, const Configuration &conf) {
+  std::map<Id, Direction> directions;
+  const auto &grid = game.getGrid();
+  auto players = game.getPlayerSnapshot();
+  for (const auto &[id, player] : *players) {
+    Direction chosen = Direction::north;
+    for (auto dir : {Direction::north, Direction::east, Direction::south,
+                     Direction::west}) {
+      const auto pos = player.position + cycles::getDirectionVector(dir);
+      if (pos.x >= 0 && pos.x < conf.gridWidth && pos.y >= 0 &&
+          pos.y < conf.gridHeight && grid[pos.y * conf.gridWidth + pos.x] == 0) {
+        chosen = dir;
+        break;
+      }
+    }
+    directions[id] = chosen;
+  }
+  return directions;
+}
+
+void benchMovePlayers(int numPlayers, int gridWidth, int gridHeight,
+                      int frames) {
+  auto conf = makeConfig(gridWidth, gridHeight);
+  Game game(conf);
+  for (int i = 0; i < numPlayers; i++) {
+    game.addPlayer("bench" + std::to_string(i));
+  }
+  double totalNs = 0;
+  std::size_t allocations = 0;
+  for (int frame = 0; frame < frames; frame++) {
+    game.setFrame(frame);
+    auto directions = pickDirections(game, conf);
+    const auto allocsBefore = g_allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    game.movePlayers(directions);
+    const auto stop = std::chrono::steady_clock::now();
+    totalNs += std::chrono::duration<double, std::nano>(stop - start).count();
+    allocations += g_allocations.load(std::memory_order_relaxed) - allocsBefore;
+  }
+  report("movePlayers players=" + std::to_string(numPlayers) + " grid=" +
+             std::to_string(gridWidth) + "x" + std::to_string(gridHeight),
+         frames, totalNs, allocations);
+}
+
+void benchAddPlayer(int gridWidth, int gridHeight, int warmupFrames) {
+  auto conf = makeConfig(gridWidth, gridHeight);
+  Game game(conf);
+  for (int i = 0; i < 20; i++) {
+    game.addPlayer("warm" + std::to_string(i));
+  }
+  // Let tails grow so the spawn sampler has to work against occupancy
+  for (int frame = 0; frame < warmupFrames; frame++) {
+    game.setFrame(frame);
+    game.movePlayers(pickDirections(game, conf));
+  }
+  const int spawns = 30;
+  const auto allocsBefore = g_allocations.load(std::memory_order_relaxed);
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < spawns; i++) {
+    game.addPlayer("spawn" + std::to_string(i));
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  report("addPlayer grid=" + std::to_string(gridWidth) + "x" +
+             std::to_string(gridHeight) + " warmup=" +
+             std::to_string(warmupFrames),
+         spawns, std::chrono::duration<double, std::nano>(stop - start).count(),
+         g_allocations.load(std::memory_order_relaxed) - allocsBefore);
+}
+
+void benchSnapshotSerialization(int numPlayers, int gridWidth,
+                                int gridHeight) {
+  auto conf = makeConfig(gridWidth, gridHeight);
+  Game game(conf);
+  for (int i = 0; i < numPlayers; i++) {
+    game.addPlayer("bench" + std::to_string(i));
+  }
+  const auto &grid = game.getGrid();
+  const int ops = 200;
+  const auto allocsBefore = g_allocations.load(std::memory_order_relaxed);
+  const auto start = std::chrono::steady_clock::now();
+  for (int op = 0; op < ops; op++) {
+    sf::Packet packet;
+    packet << conf.gridWidth << conf.gridHeight;
+    auto players = game.getPlayerSnapshot();
+    packet << static_cast<sf::Uint32>(players->size());
+    for (const auto &[id, player] : *players) {
+      packet << player.position.x << player.position.y << player.color.r
+             << player.color.g << player.color.b << player.name << id << op;
+    }
+    packet.append(grid.data(), grid.size() * sizeof(sf::Uint8));
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  report("snapshot players=" + std::to_string(numPlayers) + " grid=" +
+             std::to_string(gridWidth) + "x" + std::to_string(gridHeight),
+         ops, std::chrono::duration<double, std::nano>(stop - start).count(),
+         g_allocations.load(std::memory_order_relaxed) - allocsBefore);
+}
+
+// Re-simulate a recorded match (server config key replayFile) so the bench
+// can run against real tournament input instead of the synthetic steering
+void benchReplay(const std::string &path) {
+  cycles_server::ReplayPlayer replay;
+  if (!replay.open(path)) {
+    return;
+  }
+  auto conf = makeConfig(replay.gridWidth(), replay.gridHeight());
+  Game game(conf);
+  const auto allocsBefore = g_allocations.load(std::memory_order_relaxed);
+  const auto start = std::chrono::steady_clock::now();
+  const int ticks = replay.run(game);
+  const auto stop = std::chrono::steady_clock::now();
+  if (ticks == 0) {
+    std::printf("%-48s no ticks\n", ("replay " + path).c_str());
+    return;
+  }
+  report("replay " + path, ticks,
+         std::chrono::duration<double, std::nano>(stop - start).count(),
+         g_allocations.load(std::memory_order_relaxed) - allocsBefore);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  spdlog::set_level(spdlog::level::off);
+  std::srand(12345);
+  for (int players : {4, 16, 60}) {
+    benchMovePlayers(players, 100, 100, 2000);
+  }
+  benchMovePlayers(60, 500, 500, 2000);
+  benchAddPlayer(100, 100, 0);
+  benchAddPlayer(100, 100, 2000);
+  for (int grid : {100, 500}) {
+    benchSnapshotSerialization(30, grid, grid);
+  }
+  // Any replay files passed on the command line become extra benchmarks
+  for (int i = 1; i < argc; i++) {
+    benchReplay(argv[i]);
+  }
+  return 0;
+}
@@ -1,8 +1,15 @@
 #pragma once
 #include "utils.h"
 #include <SFML/Graphics.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 namespace cycles {
 
@@ -36,9 +43,30 @@ struct GameState {
    */
   std::vector<Id> grid;
 
+  /**
+   * @brief Occupancy bitset kept in sync with the grid
+   *
+   * Bit (i & 63) of word (i >> 6) is set when cell i (row-major index) is
+   * occupied. One 64-bit word covers 64 consecutive cells, so bots can test
+   * whole runs of cells per instruction instead of probing bytes.
+   */
+  std::vector<std::uint64_t> occupancy;
+
   int gridWidth;  ///< The width of the grid (in cells)
   int gridHeight; ///< The height of the grid (in cells)
 
+  /**
+   * @brief The part of the grid this state actually holds
+   *
+   * On an interest-managed server, `grid` and `occupancy` cover only a
+   * window around your head; these fields give its position and size. With
+   * full snapshots the window is the whole grid (offset 0, grid
+   * dimensions), so window-aware code works unchanged in both modes.
+   */
+  sf::Vector2i windowOffset = {0, 0};
+  int windowWidth = 0;  ///< The width of the held window (in cells)
+  int windowHeight = 0; ///< The height of the held window (in cells)
+
   /**
    * @brief A vector with the players in the game
    */
@@ -55,7 +83,8 @@ struct GameState {
    * @return Id The identifier of the player occupying the cell (0 if empty)
    */
   Id getGridCell(sf::Vector2i position) const {
-    return grid[position.y * gridWidth + position.x];
+    return grid[(position.y - windowOffset.y) * windowWidth +
+                (position.x - windowOffset.x)];
   }
 
   /**
@@ -66,7 +95,9 @@ struct GameState {
    * @return false if the cell is not empty
    */
   bool isCellEmpty(sf::Vector2i position) const {
-    return getGridCell(position) == 0;
+    const size_t index = (position.y - windowOffset.y) * windowWidth +
+                         (position.x - windowOffset.x);
+    return !((occupancy[index >> 6] >> (index & 63)) & 1);
   }
 
   /**
@@ -81,9 +112,66 @@ struct GameState {
            position.y < gridHeight;
   }
 
+  /**
+   * @brief Check if a position lies within the held window
+   *
+   * Only positions inside the window may be passed to getGridCell and
+   * isCellEmpty; everything outside is unknown to this state.
+   *
+   * @param position The position to check
+   * @return true if the position is inside the window
+   * @return false if the position is outside the window
+   */
+  bool isInsideWindow(sf::Vector2i position) const {
+    return position.x >= windowOffset.x &&
+           position.x < windowOffset.x + windowWidth &&
+           position.y >= windowOffset.y &&
+           position.y < windowOffset.y + windowHeight;
+  }
+
 private:
   friend Connection;
+  // Lets the protocol round-trip tests drive the apply paths directly,
+  // without a socket
+  friend struct GameStateTestPeer;
+
+  // Player names and colors arrive once per roster change, not every frame;
+  // this cache resolves the per-frame (id, position) list back into full
+  // Player entries
+  std::map<Id, Player> roster;
+  sf::Uint32 rosterVersion = 0; ///< Version of the cached roster
+
   GameState(sf::Packet &packet);
+
+  // Deserialize the shared packet header (grid size, optional roster block
+  // and the per-frame player positions)
+  void readPlayers(sf::Packet &packet);
+
+  // Deserialize a full keyframe into this state, reusing the grid and
+  // player buffers
+  void applyKeyframe(sf::Packet &packet);
+
+  // Apply a delta packet of changed (index, Id) pairs on top of this state
+  void applyDelta(sf::Packet &packet);
+
+  // Apply a windowed frame: the player list plus only the cells around
+  // this client's head
+  void applyWindow(sf::Packet &packet);
+
+  // Apply a cumulative delta (all changes since the keyframe it names).
+  // Returns false when the packet is stale or based on a keyframe this
+  // state has not seen, in which case nothing is modified.
+  bool applyCumulativeDelta(sf::Packet &packet);
+
+  int lastKeyframeFrame = -1; ///< Frame of the last keyframe applied
+
+  void setOccupancy(size_t index, bool occupied) {
+    if (occupied) {
+      occupancy[index >> 6] |= std::uint64_t(1) << (index & 63);
+    } else {
+      occupancy[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+    }
+  }
 };
 
 /**
@@ -92,9 +180,27 @@ private:
  */
 class Connection {
   std::shared_ptr<sf::TcpSocket> socket;
+  sf::UdpSocket udpSocket; ///< Lossy state channel, when the server accepts it
+  sf::Uint8 serverFeatures = 0; ///< Features the server accepted at connect
   int frameNumber = 0;
   int lastFrameSent = -1;
   std::string playerName;
+  GameState lastState; ///< Reconstructed state that delta packets are applied to
+  std::thread receiverThread;
+  std::mutex stateMutex;
+  std::condition_variable stateCv;
+  bool stateReady = false;
+  std::atomic<bool> receiverRunning{false};
+
+  // Background loop that receives and parses the next game state while the
+  // bot is still thinking about the current one
+  void receiverLoop();
+
+  // Parse one state packet into lastState. Packets from the lossy UDP
+  // channel may only carry cumulative deltas; anything else arriving there
+  // is dropped rather than parsed, so a stray datagram cannot reach the
+  // hard-failing keyframe path
+  void handleStatePacket(sf::Packet &packet, bool lossy = false);
 
 public:
   /**
@@ -123,10 +229,39 @@ public:
    * Will block until the game state is received.
    * Can only be called once per frame.
    *
+   * The state is received and parsed on a background thread while the bot
+   * computes its move, so calling this right after sendMove usually returns
+   * without waiting on the network.
+   *
    * @return GameState The game state
    */
   GameState receiveGameState();
 
+  /**
+   * @brief Receive the game state into a caller-owned GameState
+   *
+   * Same contract as receiveGameState(), but deserializes into the given
+   * object, reusing the capacity of its grid and players vectors. A bot
+   * that keeps one GameState alive across frames makes no per-frame
+   * allocations in steady state.
+   *
+   * @param reuse The game state to overwrite
+   */
+  void receiveGameState(GameState &reuse);
+
+  /**
+   * @brief Poll for the next game state without blocking
+   *
+   * Returns the latest state parsed by the background receiver, or
+   * std::nullopt if no new state has arrived since the last one consumed.
+   * A state returned here counts as received for the once-per-frame rules.
+   *
+   * @return std::optional<GameState> The game state, if one is available
+   */
+  std::optional<GameState> pollGameState();
+
+  ~Connection();
+
   /**
    * @brief Check if the connection is active
    *
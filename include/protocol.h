@@ -0,0 +1,125 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstring>
+
+namespace cycles {
+namespace protocol {
+
+/**
+ * @brief The kind of game state packet sent by the server
+ *
+ * Keyframe packets carry the full grid. Delta packets carry only the cells
+ * that changed since the previous frame, as (index, Id) pairs, and are
+ * applied on top of the last reconstructed state.
+ *
+ * Both kinds start with a roster version and an optional roster block of
+ * per-player metadata (id, name, color). Names and colors never change
+ * after a join, so the roster travels only in keyframes and on frames where
+ * the set of players changed; the per-frame player list is just ids and
+ * positions, resolved against the client's cached roster.
+ */
+enum class SnapshotKind : sf::Uint8 {
+  Keyframe = 0,
+  Delta = 1,
+  /**
+   * A delta carrying every cell changed since the last periodic keyframe,
+   * prefixed with that keyframe's frame number. Any one of these on top of
+   * that keyframe fully reconstructs the state, which makes them safe to
+   * ship over a lossy channel: the client drops stale or mismatched ones
+   * and just applies the next.
+   */
+  CumulativeDelta = 2,
+  /**
+   * A self-contained frame carrying only the window of the grid around the
+   * client's own head (offset, dimensions and raw cells), sent when the
+   * server runs with an interest radius. Bandwidth and parse cost track the
+   * window, not the grid.
+   */
+  Window = 3,
+};
+
+/**
+ * @brief Optional capabilities negotiated during the name/color handshake
+ *
+ * The client appends a feature byte to its name packet; the server echoes
+ * the subset it accepted after the color. An absent or zero byte means no
+ * optional extensions: the client still receives the kind-prefixed
+ * Keyframe/Delta framing, just with raw grids over TCP only. The byte
+ * gates extensions on top of that framing, not compatibility with
+ * pre-framing binaries.
+ */
+enum Feature : sf::Uint8 {
+  CompressedGrids = 1 << 0, ///< Keyframe grids may travel run-length encoded
+  /**
+   * Per-frame state arrives as cumulative deltas on a UDP socket whose port
+   * the client advertises at the handshake, latest-wins instead of queueing
+   * behind a TCP retransmit. Keyframes and moves stay on TCP.
+   */
+  UdpSnapshots = 1 << 1,
+  /**
+   * The client understands Window packets, so an interest-managed server
+   * may send it just the grid around its head instead of the whole grid.
+   */
+  WindowedSnapshots = 1 << 2,
+  /**
+   * Read-only viewer. The server spawns no player and never reads from the
+   * connection; the client receives periodic keyframes and cumulative
+   * deltas from a broadcast tier fed by one shared serialization per tick.
+   * The client library requests this when CYCLES_SPECTATE is set in the
+   * environment.
+   */
+  Spectator = 1 << 3,
+};
+
+/// How the grid block at the end of a keyframe is encoded
+enum class GridEncoding : sf::Uint8 { Raw = 0, Rle = 1 };
+
+/**
+ * @brief Append the grid as (value, run length) pairs
+ *
+ * Grids are mostly zeros with long single-color runs, so wire size tracks
+ * the number of occupied regions instead of the grid area.
+ */
+inline void appendRleGrid(sf::Packet &packet, const sf::Uint8 *cells,
+                          sf::Uint32 count) {
+  sf::Uint32 runs = 0;
+  for (sf::Uint32 i = 0; i < count; runs++) {
+    sf::Uint32 j = i;
+    while (j < count && cells[j] == cells[i]) {
+      j++;
+    }
+    i = j;
+  }
+  packet << runs;
+  for (sf::Uint32 i = 0; i < count;) {
+    sf::Uint32 j = i;
+    while (j < count && cells[j] == cells[i]) {
+      j++;
+    }
+    packet << cells[i] << static_cast<sf::Uint32>(j - i);
+    i = j;
+  }
+}
+
+/// Decode a run-length encoded grid block; returns false on a malformed one
+inline bool readRleGrid(sf::Packet &packet, sf::Uint8 *cells,
+                        sf::Uint32 count) {
+  sf::Uint32 runs;
+  if (!(packet >> runs)) {
+    return false;
+  }
+  sf::Uint32 at = 0;
+  for (sf::Uint32 run = 0; run < runs; run++) {
+    sf::Uint8 value;
+    sf::Uint32 length;
+    if (!(packet >> value >> length) || at + length > count) {
+      return false;
+    }
+    std::memset(cells + at, value, length);
+    at += length;
+  }
+  return at == count;
+}
+
+} // namespace protocol
+} // namespace cycles
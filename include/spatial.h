@@ -0,0 +1,88 @@
+#pragma once
+#include "api.h"
+#include <cstdint>
+#include <vector>
+
+namespace cycles {
+namespace spatial {
+
+/**
+ * @brief Breadth-first distance field over the game grid
+ *
+ * Computes, for every cell, the length of the shortest path of empty cells
+ * from a source position — the building block for flood fill, reachable-area
+ * (territory) counting and "how far is that wall" queries.
+ *
+ * Everything runs on flat row-major arrays with an array-backed frontier
+ * queue: no hash maps, no node allocations. Keep one DistanceField alive
+ * across frames and compute() makes no allocations in steady state, so it
+ * fits comfortably inside a bot's reply budget even on large grids.
+ */
+class DistanceField {
+  std::vector<int> distances;
+  std::vector<std::uint32_t> frontier;
+  sf::Vector2i offset = {0, 0};
+  int width = 0;
+  int height = 0;
+  int reachable = 0;
+
+public:
+  /// Distance value of cells that cannot be reached from the source
+  static constexpr int unreachable = -1;
+
+  /**
+   * @brief Flood the grid from a source position
+   *
+   * The source itself may be occupied (it usually is: it is your head);
+   * every other cell is traversable only when empty. The search covers the
+   * window the state holds — the whole grid with full snapshots, the area
+   * around your head on an interest-managed server.
+   *
+   * @param state The game state to search over
+   * @param source The position the distances are measured from
+   */
+  void compute(const GameState &state, sf::Vector2i source);
+
+  /**
+   * @brief Get the distance from the source to a position
+   *
+   * @param position The position to query
+   * @return int The shortest-path distance, or `unreachable`
+   */
+  int distanceTo(sf::Vector2i position) const {
+    return distances[(position.y - offset.y) * width + (position.x - offset.x)];
+  }
+
+  /**
+   * @brief Number of cells reachable from the source, including it
+   *
+   * This is the bot's territory: the area it can still get to before
+   * anything else changes.
+   *
+   * @return int The number of reachable cells
+   */
+  int reachableCount() const { return reachable; }
+
+  /**
+   * @brief The whole field as a flat row-major array over the window
+   *
+   * @return const std::vector<int>& One distance per cell, `unreachable`
+   * where no empty path exists
+   */
+  const std::vector<int> &data() const { return distances; }
+};
+
+/**
+ * @brief Count the cells reachable from a position
+ *
+ * Convenience wrapper for one-off queries; bots that ask every frame should
+ * keep a DistanceField instead and reuse its buffers.
+ *
+ * @param state The game state to search over
+ * @param source The position to flood from
+ * @return int The number of reachable cells, including the source
+ */
+int territorySize(const GameState &state, sf::Vector2i source);
+
+} // namespace spatial
+} // namespace cycles
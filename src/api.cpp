@@ -1,25 +1,111 @@
 #include "api.h"
+#include "protocol.h"
 #include <SFML/Network.hpp>
+#include <cstring>
 #include <spdlog/spdlog.h>
 
 namespace cycles {
 
-GameState::GameState(sf::Packet &packet) {
+void GameState::readPlayers(sf::Packet &packet) {
   packet >> gridWidth >> gridHeight;
+  // Full-grid window by default; applyWindow overrides this afterwards
+  windowOffset = {0, 0};
+  windowWidth = gridWidth;
+  windowHeight = gridHeight;
+  sf::Uint32 version;
+  sf::Uint8 hasRoster;
+  packet >> version >> hasRoster;
+  if (hasRoster) {
+    roster.clear();
+    sf::Uint32 rosterCount;
+    packet >> rosterCount;
+    for (sf::Uint32 i = 0; i < rosterCount; ++i) {
+      Id playerId;
+      std::string playerName;
+      sf::Uint8 r, g, b;
+      packet >> playerId >> playerName >> r >> g >> b;
+      roster[playerId] = {playerName, sf::Color(r, g, b), sf::Vector2i(0, 0),
+                          playerId};
+    }
+    rosterVersion = version;
+  } else if (version != rosterVersion) {
+    spdlog::critical("Server roster version {} but {} is cached", version,
+                     rosterVersion);
+    exit(1);
+  }
+  packet >> frameNumber;
   sf::Uint32 playerCount;
   packet >> playerCount;
   players.resize(playerCount);
   for (sf::Uint32 i = 0; i < playerCount; ++i) {
     int x, y;
-    sf::Uint8 r, g, b;
     Id playerId;
-    std::string playerName;
-    packet >> x >> y >> r >> g >> b >> playerName >> playerId >> frameNumber;
-    players[i] = {playerName, sf::Color(r, g, b), sf::Vector2i(x, y), playerId};
+    packet >> playerId >> x >> y;
+    auto &player = players[i];
+    // Ids arrive in the same order every frame, so in steady state the slot
+    // already holds this player's metadata and no strings are copied
+    if (player.id != playerId || player.name.empty()) {
+      auto it = roster.find(playerId);
+      if (it == roster.end()) {
+        spdlog::critical("Player {} is not in the cached roster", playerId);
+        exit(1);
+      }
+      player = it->second;
+    }
+    player.position = sf::Vector2i(x, y);
   }
+}
+
+GameState::GameState(sf::Packet &packet) { applyKeyframe(packet); }
+
+void GameState::applyKeyframe(sf::Packet &packet) {
+  readPlayers(packet);
   grid.resize(gridWidth * gridHeight);
-  for (auto &cell : grid) {
-    packet >> cell;
+  sf::Uint8 encoding;
+  packet >> encoding;
+  if (static_cast<protocol::GridEncoding>(encoding) ==
+      protocol::GridEncoding::Rle) {
+    if (!protocol::readRleGrid(packet, grid.data(), grid.size())) {
+      spdlog::critical("Malformed run-length encoded grid block");
+      exit(1);
+    }
+  } else {
+    // The grid is the last field and travels as one contiguous block,
+    // extract it with a single copy instead of one operator>> per cell
+    const auto remaining = packet.getDataSize() - packet.getReadPosition();
+    if (remaining != grid.size() * sizeof(Id)) {
+      spdlog::critical("Grid block has {} bytes, expected {}", remaining,
+                       grid.size() * sizeof(Id));
+      exit(1);
+    }
+    std::memcpy(grid.data(),
+                static_cast<const char *>(packet.getData()) +
+                    packet.getReadPosition(),
+                remaining);
+  }
+  // Rebuild the occupancy bitset from the fresh grid
+  occupancy.assign((grid.size() + 63) / 64, 0);
+  for (size_t i = 0; i < grid.size(); ++i) {
+    if (grid[i]) {
+      occupancy[i >> 6] |= std::uint64_t(1) << (i & 63);
+    }
+  }
+  lastKeyframeFrame = frameNumber;
+}
+
+void GameState::applyDelta(sf::Packet &packet) {
+  readPlayers(packet);
+  grid.resize(gridWidth * gridHeight);
+  sf::Uint32 changedCells;
+  packet >> changedCells;
+  for (sf::Uint32 i = 0; i < changedCells; ++i) {
+    sf::Uint32 index;
+    Id value;
+    packet >> index >> value;
+    if (index < grid.size()) {
+      grid[index] = value;
+      setOccupancy(index, value != 0);
+    }
   }
   //Check that the whole packet was read
   if (!packet.endOfPacket()) {
@@ -28,6 +114,56 @@ GameState::GameState(sf::Packet &packet) {
   }
 }
 
+void GameState::applyWindow(sf::Packet &packet) {
+  readPlayers(packet);
+  packet >> windowOffset.x >> windowOffset.y >> windowWidth >> windowHeight;
+  grid.resize(static_cast<size_t>(windowWidth) * windowHeight);
+  const auto remaining = packet.getDataSize() - packet.getReadPosition();
+  if (remaining != grid.size() * sizeof(Id)) {
+    spdlog::critical("Window block has {} bytes, expected {}", remaining,
+                     grid.size() * sizeof(Id));
+    exit(1);
+  }
+  std::memcpy(grid.data(),
+              static_cast<const char *>(packet.getData()) +
+                  packet.getReadPosition(),
+              remaining);
+  occupancy.assign((grid.size() + 63) / 64, 0);
+  for (size_t i = 0; i < grid.size(); ++i) {
+    if (grid[i]) {
+      occupancy[i >> 6] |= std::uint64_t(1) << (i & 63);
+    }
+  }
+}
+
+bool GameState::applyCumulativeDelta(sf::Packet &packet) {
+  sf::Uint32 baseFrame;
+  sf::Int32 packetFrame;
+  if (!(packet >> baseFrame >> packetFrame)) {
+    return false;
+  }
+  // Latest wins: drop datagrams older than what we already have, and ones
+  // built on a keyframe this state has not applied yet
+  if (static_cast<int>(baseFrame) != lastKeyframeFrame ||
+      packetFrame <= frameNumber) {
+    return false;
+  }
+  readPlayers(packet);
+  grid.resize(gridWidth * gridHeight);
+  sf::Uint32 changedCells;
+  packet >> changedCells;
+  for (sf::Uint32 i = 0; i < changedCells; ++i) {
+    sf::Uint32 index;
+    Id value;
+    packet >> index >> value;
+    if (index < grid.size()) {
+      grid[index] = value;
+      setOccupancy(index, value != 0);
+    }
+  }
+  return true;
+}
+
 namespace detail {
 std::shared_ptr<sf::TcpSocket> establishLink() {
   spdlog::debug("Trying to connect");
@@ -90,11 +226,27 @@ sf::Packet receivePacket(std::shared_ptr<sf::TcpSocket> socket,
   return packet;
 }
 
-std::shared_ptr<sf::TcpSocket> connectToServer(std::string playerName) {
+std::shared_ptr<sf::TcpSocket> connectToServer(std::string playerName,
+                                               unsigned short udpPort) {
   auto socket = detail::establishLink();
-  // Send name to server
+  // Send name to server, advertising the optional features we can decode
+  sf::Uint8 features = protocol::CompressedGrids | protocol::WindowedSnapshots;
+  if (udpPort != 0) {
+    features |= protocol::UdpSnapshots;
+  }
+  // Viewers connect read-only: the server spawns no player for them and
+  // they must never call sendMove
+  if (std::getenv("CYCLES_SPECTATE") != nullptr) {
+    features |= protocol::Spectator;
+    features &= ~protocol::UdpSnapshots;
+  }
   sf::Packet namePacket;
-  namePacket << playerName;
+  namePacket << playerName << features;
+  // Tournament servers route clients to a match by this token; single-match
+  // servers ignore it
+  const char *matchToken = std::getenv("CYCLES_MATCH");
+  namePacket << std::string(matchToken != nullptr ? matchToken : "");
+  namePacket << udpPort;
   detail::sendPacket(socket, namePacket);
   return socket;
 }
@@ -106,7 +258,15 @@ sf::Color Connection::connect(std::string playerName) {
   if (socket != nullptr) {
     spdlog::critical("Connection already established");
   }
-  socket = detail::connectToServer(playerName);
+  // Offer the server a lossy state channel; moves stay on TCP
+  unsigned short udpPort = 0;
+  if (udpSocket.bind(sf::Socket::AnyPort) == sf::Socket::Done) {
+    udpPort = udpSocket.getLocalPort();
+  } else {
+    spdlog::warn("{}: Could not bind a UDP socket, staying on TCP",
+                 playerName);
+  }
+  socket = detail::connectToServer(playerName, udpPort);
   sf::Color color;
   sf::Packet colorPacket = detail::receivePacket(socket);
   sf::Uint8 r, g, b;
@@ -115,11 +275,116 @@ sf::Color Connection::connect(std::string playerName) {
     exit(1);
   }
   color = sf::Color(r, g, b);
+  // Features the server accepted; grid encodings are self-describing, but
+  // the UDP channel only operates when both ends agreed to it
+  if (!colorPacket.endOfPacket()) {
+    colorPacket >> serverFeatures;
+  }
+  if (!(serverFeatures & protocol::UdpSnapshots)) {
+    udpSocket.unbind();
+  }
   spdlog::info("{}: Assigned color: R={} G={} B={}", playerName,
                static_cast<int>(r), static_cast<int>(g), static_cast<int>(b));
+  spdlog::debug("{}: Negotiated features: {:#x}", playerName, serverFeatures);
+  receiverRunning = true;
+  receiverThread = std::thread(&Connection::receiverLoop, this);
   return color;
 }
 
+void Connection::handleStatePacket(sf::Packet &packet, bool lossy) {
+  sf::Uint8 kind;
+  if (!(packet >> kind)) {
+    return;
+  }
+  // The server only ever ships cumulative deltas over UDP, and that apply
+  // path fails soft; the others trust their input the way TCP allows, so a
+  // stray datagram must never reach them
+  if (lossy &&
+      static_cast<protocol::SnapshotKind>(kind) !=
+          protocol::SnapshotKind::CumulativeDelta) {
+    spdlog::debug("Dropping unexpected datagram of kind {}", kind);
+    return;
+  }
+  bool updated = true;
+  {
+    std::scoped_lock lock(stateMutex);
+    switch (static_cast<protocol::SnapshotKind>(kind)) {
+    case protocol::SnapshotKind::Keyframe:
+      lastState.applyKeyframe(packet);
+      break;
+    case protocol::SnapshotKind::Delta:
+      lastState.applyDelta(packet);
+      break;
+    case protocol::SnapshotKind::CumulativeDelta:
+      // Stale or mismatched datagrams are simply dropped; a newer one or
+      // the next keyframe supersedes them
+      updated = lastState.applyCumulativeDelta(packet);
+      break;
+    case protocol::SnapshotKind::Window:
+      lastState.applyWindow(packet);
+      break;
+    }
+    if (updated) {
+      stateReady = true;
+    }
+  }
+  if (updated) {
+    stateCv.notify_all();
+  }
+}
+
+void Connection::receiverLoop() {
+  socket->setBlocking(true);
+  const bool udp = serverFeatures & protocol::UdpSnapshots;
+  sf::SocketSelector selector;
+  selector.add(*socket);
+  if (udp) {
+    selector.add(udpSocket);
+  }
+  while (receiverRunning) {
+    if (udp) {
+      if (!selector.wait(sf::milliseconds(100))) {
+        continue;
+      }
+      if (selector.isReady(udpSocket)) {
+        sf::Packet packet;
+        sf::IpAddress sender;
+        unsigned short senderPort;
+        if (udpSocket.receive(packet, sender, senderPort) ==
+                sf::Socket::Done &&
+            sender == socket->getRemoteAddress()) {
+          // Anyone can write to our port; take state only from the server
+          handleStatePacket(packet, true);
+        }
+      }
+      if (!selector.isReady(*socket)) {
+        continue;
+      }
+    }
+    sf::Packet packet;
+    const auto status = socket->receive(packet);
+    if (status != sf::Socket::Done) {
+      if (receiverRunning) {
+        spdlog::debug("Receiver stopped: {}", socketErrorToString(status));
+      }
+      break;
+    }
+    handleStatePacket(packet);
+  }
+  receiverRunning = false;
+  stateCv.notify_all();
+}
+
+Connection::~Connection() {
+  receiverRunning = false;
+  if (socket != nullptr) {
+    socket->disconnect();
+  }
+  if (receiverThread.joinable()) {
+    receiverThread.join();
+  }
+}
+
 void Connection::sendMove(Direction direction) {
   if (frameNumber == lastFrameSent) {
     spdlog::warn("Trying to send move twice in the same frame, call "
@@ -135,10 +400,39 @@ void Connection::sendMove(Direction direction) {
 
 GameState Connection::receiveGameState() {
   spdlog::debug("Receiving game state");
-  auto packet = detail::receivePacket(socket);
-  GameState state(packet);
-  frameNumber = state.frameNumber;
-  return state;
+  std::unique_lock lock(stateMutex);
+  stateCv.wait(lock, [this] { return stateReady || !receiverRunning; });
+  if (!stateReady) {
+    spdlog::critical("Failed to receive packet from server");
+    exit(1);
+  }
+  stateReady = false;
+  frameNumber = lastState.frameNumber;
+  return lastState;
+}
+
+void Connection::receiveGameState(GameState &reuse) {
+  spdlog::debug("Receiving game state");
+  std::unique_lock lock(stateMutex);
+  stateCv.wait(lock, [this] { return stateReady || !receiverRunning; });
+  if (!stateReady) {
+    spdlog::critical("Failed to receive packet from server");
+    exit(1);
+  }
+  stateReady = false;
+  frameNumber = lastState.frameNumber;
+  // Vector copy assignment reuses the capacity of the caller's buffers
+  reuse = lastState;
+}
+
+std::optional<GameState> Connection::pollGameState() {
+  std::scoped_lock lock(stateMutex);
+  if (!stateReady) {
+    return std::nullopt;
+  }
+  stateReady = false;
+  frameNumber = lastState.frameNumber;
+  return lastState;
 }
 
 bool Connection::isActive() {
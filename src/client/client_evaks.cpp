@@ -112,7 +112,7 @@ private:
     // Update the bot's state with the current game state
     void updateState() {
         try {
-            state = connection.receiveGameState();
+            connection.receiveGameState(state);
             bool playerFound = false;
             for (const auto& player : state.players) {
                 if (player.name == name) {
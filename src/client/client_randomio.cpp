@@ -63,7 +63,7 @@ class BotClient {
   }
 
   void receiveGameState() {
-    state = connection.receiveGameState();
+    connection.receiveGameState(state);
     for (const auto &player : state.players) {
       if (player.name == name) {
         my_player = player;
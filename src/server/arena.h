@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace cycles_server {
+
+/**
+ * @brief Monotonic bump allocator for data that lives at most one tick
+ *
+ * reset() recycles the whole block in O(1) at the start of each frame, so
+ * the tick-transient containers stop hitting the heap once the arena has
+ * warmed up. Requests that do not fit the block fall back to the heap and
+ * are released on the next reset, so correctness never depends on the
+ * capacity guess.
+ */
+class FrameArena {
+  std::vector<std::byte> block;
+  size_t offset = 0;
+  std::vector<void *> overflow;
+
+public:
+  explicit FrameArena(size_t capacity = 1 << 16) : block(capacity) {}
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  ~FrameArena() { reset(); }
+
+  void *allocate(size_t bytes, size_t alignment) {
+    const size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+    if (aligned + bytes > block.size()) {
+      void *fallback = ::operator new(bytes);
+      overflow.push_back(fallback);
+      return fallback;
+    }
+    offset = aligned + bytes;
+    return block.data() + aligned;
+  }
+
+  void reset() {
+    offset = 0;
+    for (auto *fallback : overflow) {
+      ::operator delete(fallback);
+    }
+    overflow.clear();
+  }
+};
+
+/**
+ * @brief std-compatible allocator handing out memory from a FrameArena
+ *
+ * Deallocation is a no-op; the arena reclaims everything at once on reset.
+ */
+template <typename T> class ArenaAllocator {
+  FrameArena *arena;
+
+  template <typename U> friend class ArenaAllocator;
+
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(FrameArena &arena) : arena(&arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *, size_t) {}
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &other) const {
+    return arena == other.arena;
+  }
+
+  template <typename U> bool operator!=(const ArenaAllocator<U> &other) const {
+    return arena != other.arena;
+  }
+};
+
+// Tick-transient vector backed by the frame arena
+template <typename T> using TickVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace cycles_server
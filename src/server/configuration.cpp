@@ -16,6 +16,9 @@ namespace cycles_server{
     if (config["maxClients"]) {
       maxClients = config["maxClients"].as<int>();
     }
+    if (config["maxSpectators"]) {
+      maxSpectators = config["maxSpectators"].as<int>();
+    }
     if (config["gridWidth"]) {
       gridWidth = config["gridWidth"].as<int>();
     }
@@ -34,11 +37,79 @@ namespace cycles_server{
     if (config["enablePostProcessing"]) {
       enablePostProcessing = config["enablePostProcessing"].as<bool>();
     }
+    if (config["headless"]) {
+      headless = config["headless"].as<bool>();
+    }
+    if (config["minClients"]) {
+      minClients = config["minClients"].as<int>();
+    }
+    if (config["startTimeout"]) {
+      startTimeout = config["startTimeout"].as<int>();
+    }
+    if (config["uncappedTickRate"]) {
+      uncappedTickRate = config["uncappedTickRate"].as<bool>();
+    }
+    if (config["tickRate"]) {
+      tickRate = config["tickRate"].as<int>();
+      if (tickRate <= 0) {
+        spdlog::error("tickRate must be positive, falling back to 30");
+        tickRate = 30;
+      }
+    }
+    if (config["statsCsv"]) {
+      statsCsv = config["statsCsv"].as<std::string>();
+    }
+    if (config["statsInterval"]) {
+      statsInterval = config["statsInterval"].as<int>();
+      if (statsInterval <= 0) {
+        spdlog::error("statsInterval must be positive, falling back to 150");
+        statsInterval = 150;
+      }
+    }
+    if (config["replayFile"]) {
+      replayFile = config["replayFile"].as<std::string>();
+    }
+    if (config["seed"]) {
+      seed = config["seed"].as<unsigned int>();
+      if (seed == 0) {
+        spdlog::error("seed 0 means unseeded; use any other value for "
+                      "deterministic runs");
+      }
+    }
+    if (config["interestRadius"]) {
+      interestRadius = config["interestRadius"].as<int>();
+      if (interestRadius < 0) {
+        spdlog::error("interestRadius must be non-negative, disabling");
+        interestRadius = 0;
+      }
+    }
+    if (config["tournament"]) {
+      tournament = config["tournament"].as<bool>();
+    }
+    if (config["matches"]) {
+      matches = config["matches"].as<int>();
+      if (matches <= 0) {
+        spdlog::error("matches must be positive, falling back to 1");
+        matches = 1;
+      }
+    }
+    if (config["workers"]) {
+      workers = config["workers"].as<int>();
+    }
 
-    std::set<std::string> knownParameters = {"maxClients", "gridWidth",
+    std::set<std::string> knownParameters = {"maxClients", "maxSpectators",
+					     "gridWidth",
                                              "gridHeight", "gameWidth",
                                              "gameHeight", "gameBannerHeight",
-					     "enablePostProcessing"};
+					     "enablePostProcessing",
+					     "headless", "minClients",
+					     "startTimeout",
+					     "uncappedTickRate", "tickRate",
+					     "statsCsv", "statsInterval",
+					     "replayFile", "seed",
+					     "interestRadius",
+					     "tournament",
+					     "matches", "workers"};
     // Warn if there are unknown parameters
     for (const auto &it : config) {
       if (knownParameters.find(it.first.as<std::string>()) ==
@@ -1,23 +1,13 @@
 #include "game_logic.h"
+#include <algorithm>
+#include <bit>
 #include <map>
 #include <random>
-#include <set>
 #include <spdlog/spdlog.h>
 
 namespace cycles_server {
 
 namespace detail {
-
-template <typename T>
-std::map<Id, T> removeNonExistentPlayers(std::map<Id, T> directions,
-                                         const std::map<Id, Player> &players) {
-  for (auto [id, direction] : directions) {
-    if (players.find(id) == players.end()) {
-      directions.erase(id);
-    }
-  }
-  return directions;
-}
   std::tuple<int, int, int> hslToRgb(float h, float s, float l) {
     float c = (1 - std::abs(2 * l - 1)) * s;
     float x = c * (1 - std::abs(std::fmod(h / 60.0, 2) - 1));
@@ -72,121 +62,220 @@ sf::Color getRandomColor(auto rng) {
 } // namespace detail
 
 Id Game::addPlayer(const std::string &name) {
+  return addPlayer(name, sampleFreeCell());
+}
+
+std::uint64_t Game::stateHash() {
+  // FNV-1a: no dependency, and unlike std::hash its value is specified, so
+  // hashes compare across builds and machines
+  constexpr std::uint64_t prime = 1099511628211ull;
+  std::uint64_t hash = 14695981039346656037ull;
+  for (const auto cell : grid) {
+    hash = (hash ^ cell) * prime;
+  }
+  // forEach visits players in increasing Id order, so the digest does not
+  // depend on insertion history
+  players.forEach([&](Id id, const Player &player) {
+    hash = (hash ^ id) * prime;
+    hash = (hash ^ static_cast<std::uint32_t>(player.position.x)) * prime;
+    hash = (hash ^ static_cast<std::uint32_t>(player.position.y)) * prime;
+    hash = (hash ^ player.tail.size()) * prime;
+  });
+  return hash;
+}
+
+sf::Vector2i Game::sampleFreeCell() {
+  // Rejection sampling degenerates as the grid fills up; instead draw the
+  // k-th free cell directly off the occupancy bitset
+  size_t freeCells = grid.size();
+  for (auto word : occupancy) {
+    freeCells -= std::popcount(word);
+  }
+  if (freeCells == 0) {
+    spdlog::critical("No free cell left to spawn a player on");
+    exit(1);
+  }
+  std::uniform_int_distribution<size_t> dist(0, freeCells - 1);
+  size_t target = dist(rng);
+  for (size_t word = 0; word < occupancy.size(); word++) {
+    std::uint64_t freeBits = ~occupancy[word];
+    // Mask off the padding bits past the end of the grid in the last word
+    const size_t cellsInWord = std::min<size_t>(64, grid.size() - word * 64);
+    if (cellsInWord < 64) {
+      freeBits &= (std::uint64_t(1) << cellsInWord) - 1;
+    }
+    const size_t count = std::popcount(freeBits);
+    if (target >= count) {
+      target -= count;
+      continue;
+    }
+    while (target > 0) {
+      freeBits &= freeBits - 1;
+      target--;
+    }
+    const size_t index = word * 64 + std::countr_zero(freeBits);
+    return sf::Vector2i(index % conf.gridWidth, index / conf.gridWidth);
+  }
+  spdlog::critical("Occupancy bitset disagrees with the grid");
+  exit(1);
+}
+
+Id Game::addPlayer(const std::string &name, sf::Vector2i position) {
   static std::vector<uint32_t> palette = detail::generateColorPalette(300);
   gameStarted = true;
   Player newPlayer;
   newPlayer.name = name;
   newPlayer.color = sf::Color(palette[idCounter]);
   newPlayer.id = idCounter;
-  std::uniform_real_distribution<float> dist(0, 1.0);
-  do {
-    newPlayer.position.x = conf.gridWidth * dist(rng);
-    newPlayer.position.y = conf.gridHeight * dist(rng);
-  } while (getCell(newPlayer.position.x, newPlayer.position.y));
-  getCell(newPlayer.position.x, newPlayer.position.y) = newPlayer.id;
-  players[idCounter] = newPlayer;
+  newPlayer.position = position;
+  setCell(newPlayer.position.x, newPlayer.position.y, newPlayer.id);
+  players.insert(idCounter, newPlayer);
   idCounter++;
+  rosterVersion++;
+  publishSnapshot();
   return idCounter - 1;
 }
 
 void Game::removePlayer(Id id) {
-  auto player_it = players.find(id);
-  if (player_it == players.end()) {
+  if (!players.contains(id)) {
     return;
   }
-  auto &player = player_it->second;
-  getCell(player.position.x, player.position.y) = 0;
+  auto &player = players[id];
+  setCell(player.position.x, player.position.y, 0);
   for (auto tail : player.tail) {
-    getCell(tail.x, tail.y) = 0;
+    setCell(tail.x, tail.y, 0);
   }
   players.erase(id);
+  rosterVersion++;
+  publishSnapshot();
 }
 
-void Game::movePlayers(std::map<Id, Direction> directions) {
+void Game::movePlayers(const std::map<Id, Direction> &directions) {
   if (directions.size() == 0) {
     return;
   }
+  // Pick the instantiation whose grid width is a compile-time constant when
+  // this deployment's size is on the whitelist
+  withGridShape(conf.gridWidth, conf.gridHeight,
+                [&](auto shape) { movePlayersOn(shape, directions); });
+}
+
+template <typename Shape>
+void Game::movePlayersOn(Shape shape,
+                         const std::map<Id, Direction> &directions) {
   max_tail_length = 55 + frame / 100;
-  // Sanitize directions
-  directions = detail::removeNonExistentPlayers(directions, players);
-  std::map<Id, sf::Vector2i> newPositions;
-  // Transform directions to positions
+  tickArena.reset();
+  TickVector<std::pair<Id, sf::Vector2i>> newPositions{
+      ArenaAllocator<std::pair<Id, sf::Vector2i>>(tickArena)};
+  newPositions.reserve(directions.size());
+  // Transform directions to positions, dropping ids that no longer map to a
+  // live player
   for (const auto &[id, direction] : directions) {
-    auto it = players.find(id);
-    if (it == players.end()) {
+    if (!players.contains(id)) {
       continue;
     }
-    const auto &player = it->second;
+    const auto &player = players[id];
     const sf::Vector2i newPos = player.position + getDirectionVector(direction);
     spdlog::debug(
         "Game: Player {} trying to move to ({},{}) from ({},{}) in frame {}",
         player.name, newPos.x, newPos.y, player.position.x, player.position.y,
         frame);
-    newPositions[id] = newPos;
+    newPositions.emplace_back(id, newPos);
   }
   // Check for collisions
-  auto colliding = checkCollisions(newPositions);
+  auto colliding = checkCollisions(shape, newPositions);
   for (auto id : colliding) {
     removePlayer(id);
-    newPositions.erase(id);
   }
   // Move remaining players
   for (const auto &[id, newPos] : newPositions) {
-    auto it = players.find(id);
-    if (it == players.end()) {
+    if (std::binary_search(colliding.begin(), colliding.end(), id)) {
       continue;
     }
-    auto &player = it->second;
-    getCell(newPos.x, newPos.y) = player.id;
+    if (!players.contains(id)) {
+      continue;
+    }
+    auto &player = players[id];
+    setCellIndex(shape.index(newPos.x, newPos.y), player.id);
     if (player.tail.size() > max_tail_length) {
-      getCell(player.tail.back().x, player.tail.back().y) = 0;
+      setCellIndex(shape.index(player.tail.back().x, player.tail.back().y), 0);
       player.tail.pop_back();
     }
     player.tail.push_front(player.position);
     player.position = newPos;
   }
+  publishSnapshot();
 }
 
-bool Game::legalMove(sf::Vector2i newPos) {
-  if (newPos.x < 0 || newPos.x >= conf.gridWidth || newPos.y < 0 ||
-      newPos.y >= conf.gridHeight) {
+template <typename Shape>
+bool Game::legalMove(Shape shape, sf::Vector2i newPos) {
+  if (newPos.x < 0 || newPos.x >= shape.width() || newPos.y < 0 ||
+      newPos.y >= shape.height()) {
     spdlog::debug("Game: Moved out of bounds");
     return false;
   }
-  if (getCell(newPos.x, newPos.y) != 0) {
+  if (grid[shape.index(newPos.x, newPos.y)] != 0) {
     spdlog::debug("Game: Moved where player {} is",
-                  int(getCell(newPos.x, newPos.y)));
+                  int(grid[shape.index(newPos.x, newPos.y)]));
     return false;
   }
   return true;
 }
 
-std::set<Id> Game::checkCollisions(std::map<Id, sf::Vector2i> newPositions) {
-  std::set<Id> colliding;
-  // If two players are trying to go to the same position, remove both
-  for (const auto &[id1, pos1] : newPositions) {
-    for (const auto &[id2, pos2] : newPositions) {
-      if (id1 < id2 && pos1 == pos2) {
-        spdlog::debug("Game: Players {} and {} collided", id1, id2);
-        colliding.insert(id1);
-        colliding.insert(id2);
+template <typename Shape>
+TickVector<Id> Game::checkCollisions(
+    Shape shape, const TickVector<std::pair<Id, sf::Vector2i>> &newPositions) {
+  TickVector<Id> colliding{ArenaAllocator<Id>(tickArena)};
+  // Index the proposed moves by target cell so that resolving head-on
+  // collisions is a single pass over the players instead of a pairwise scan
+  TickVector<std::pair<int, Id>> claims{
+      ArenaAllocator<std::pair<int, Id>>(tickArena)};
+  claims.reserve(newPositions.size());
+  for (const auto &[id, newPos] : newPositions) {
+    // Only in-bounds proposals claim a cell: flattening an out-of-bounds
+    // position would alias another row's cell and kill its legal claimant.
+    // Out-of-bounds movers are picked up by the legalMove pass below.
+    if (newPos.x < 0 || newPos.x >= shape.width() || newPos.y < 0 ||
+        newPos.y >= shape.height()) {
+      continue;
+    }
+    claims.emplace_back(static_cast<int>(shape.index(newPos.x, newPos.y)), id);
+  }
+  std::sort(claims.begin(), claims.end());
+  // If two or more players are trying to go to the same position, remove all
+  // of them
+  for (size_t i = 0; i < claims.size();) {
+    size_t j = i;
+    while (j < claims.size() && claims[j].first == claims[i].first) {
+      j++;
+    }
+    if (j - i > 1) {
+      for (size_t k = i; k < j; k++) {
+        spdlog::debug("Game: Player {} collided with {} other players",
+                      claims[k].second, j - i - 1);
+        colliding.push_back(claims[k].second);
       }
     }
+    i = j;
   }
   // If a player is trying to go to a position where another player is, remove
   // the player
   for (const auto &[id, newPos] : newPositions) {
-    auto player = players[id];
+    const auto &player = players[id];
     spdlog::debug(
         "Game: Player {} trying to move to ({},{}) from ({},{}) in frame {}",
         player.name, newPos.x, newPos.y, player.position.x, player.position.y,
         frame);
-    if (!legalMove(newPos)) {
+    if (!legalMove(shape, newPos)) {
       spdlog::debug("Game: Player {} tried to move to an illegal position",
                     player.name);
-      colliding.insert(id);
+      colliding.push_back(id);
     }
   }
+  // Keep the result sorted and unique so callers can binary-search it
+  std::sort(colliding.begin(), colliding.end());
+  colliding.erase(std::unique(colliding.begin(), colliding.end()),
+                  colliding.end());
   return colliding;
 }
 
@@ -1,13 +1,79 @@
 #pragma once
+#include "arena.h"
+#include "grid_shape.h"
 #include "server.h"
+#include "triple_buffer.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
 #include <map>
-#include <mutex>
+#include <memory>
 #include <random>
-#include <set>
+#include <utility>
 #include <vector>
 
 namespace cycles_server {
 
+// Immutable view of the players, published once per mutation and shared by
+// all readers (server bookkeeping, serializer, renderer) without copying
+using PlayerSnapshot = std::shared_ptr<const std::map<Id, Player>>;
+
+// Everything the renderer needs for one frame, published by the game loop
+// into a triple buffer so rendering never takes a game lock
+struct RenderSnapshot {
+  PlayerSnapshot players = std::make_shared<const std::map<Id, Player>>();
+  int frame = 0;
+  bool gameOver = false;
+};
+
+/**
+ * @brief Dense player storage indexed directly by Id
+ *
+ * Id is a single byte, so there can never be more than 256 live players.
+ * Players live in a flat slot array with a bitmask recording which slots are
+ * occupied: lookup is a bounds-free index, membership is one bit test, and
+ * iteration word-scans the mask instead of chasing tree nodes.
+ */
+class PlayerRoster {
+  std::array<Player, 256> slots;
+  std::array<std::uint64_t, 4> mask{};
+
+public:
+  bool contains(Id id) const { return (mask[id >> 6] >> (id & 63)) & 1; }
+
+  Player &operator[](Id id) { return slots[id]; }
+
+  const Player &operator[](Id id) const { return slots[id]; }
+
+  void insert(Id id, const Player &player) {
+    slots[id] = player;
+    mask[id >> 6] |= std::uint64_t(1) << (id & 63);
+  }
+
+  void erase(Id id) { mask[id >> 6] &= ~(std::uint64_t(1) << (id & 63)); }
+
+  size_t size() const {
+    size_t count = 0;
+    for (auto word : mask) {
+      count += std::popcount(word);
+    }
+    return count;
+  }
+
+  // Visit every live player in increasing Id order
+  template <typename F> void forEach(F &&visit) const {
+    for (size_t word = 0; word < mask.size(); word++) {
+      std::uint64_t bits = mask[word];
+      while (bits) {
+        const Id id = static_cast<Id>(word * 64 + std::countr_zero(bits));
+        bits &= bits - 1;
+        visit(id, slots[id]);
+      }
+    }
+  }
+};
+
 // Game Logic
 class Game {
   const Configuration conf;
@@ -15,42 +81,124 @@ class Game {
   Id idCounter = 1;
   int frame = 0;
   bool gameStarted = false;
-  std::map<Id, Player> players;
+  PlayerRoster players;
+  sf::Uint32 rosterVersion = 1; // bumped whenever a player joins or leaves
   std::vector<sf::Uint8> grid;
+  // One bit per cell, kept in sync with the grid by setCell: word-at-a-time
+  // scans test 64 cells per instruction
+  std::vector<std::uint64_t> occupancy;
+  std::vector<sf::Uint32> dirtyCells;
   std::mt19937 rng;
-  std::mutex gameMutex;
+  // Published with release, read with acquire: readers on other threads
+  // (renderer, stats) grab the latest snapshot without a lock, so the tick
+  // thread never waits on them
+  std::atomic<PlayerSnapshot> snapshot{
+      std::make_shared<const std::map<Id, Player>>()};
+  TripleBuffer<RenderSnapshot> renderBuffer;
+  FrameArena tickArena; // backs the containers that live only for one tick
 
 public:
+  // A configured seed makes spawn placement (the game's only randomness)
+  // reproducible, so two runs with the same inputs play the same match
   Game(Configuration conf)
       : conf(conf), grid(conf.gridWidth * conf.gridHeight, 0),
-        rng(std::random_device()()) {}
+        occupancy((conf.gridWidth * conf.gridHeight + 63) / 64, 0),
+        rng(conf.seed != 0 ? conf.seed : std::random_device()()) {}
 
   Id addPlayer(const std::string &name);
 
+  // Place the new player at a fixed position instead of sampling one; used
+  // by replay playback to reproduce recorded spawns
+  Id addPlayer(const std::string &name, sf::Vector2i position);
+
   void removePlayer(Id id);
 
-  void movePlayers(std::map<Id, Direction> directions);
+  void movePlayers(const std::map<Id, Direction> &directions);
 
   const auto &getGrid() { return grid; }
 
-  auto getPlayers() {
-    std::scoped_lock lock(gameMutex);
-    return players;
+  const auto &getOccupancy() { return occupancy; }
+
+  // Hand over the indices of the cells written since the last call, so the
+  // server can build a delta packet. Clears the dirty list.
+  std::vector<sf::Uint32> takeDirtyCells() {
+    auto cells = std::move(dirtyCells);
+    dirtyCells.clear();
+    return cells;
+  }
+
+  // Grab the latest published snapshot; only the pointer is copied
+  PlayerSnapshot getPlayerSnapshot() {
+    return snapshot.load(std::memory_order_acquire);
   }
 
+  auto getPlayers() { return *getPlayerSnapshot(); }
+
+  // Latest frame published for rendering; wait-free, never blocks the tick
+  const RenderSnapshot &getRenderSnapshot() { return renderBuffer.read(); }
+
+  // Changes only when the set of players changes, so the server can tell
+  // when clients need a fresh roster instead of resending names every frame
+  sf::Uint32 getRosterVersion() const { return rosterVersion; }
+
   void setFrame(int frame) { this->frame = frame; }
 
   int getFrame() { return frame; }
 
   bool isGameOver() { return gameStarted && players.size() <= 1; }
 
+  // Digest of the grid and player state, stable across platforms and runs.
+  // Two seeded runs fed the same inputs must produce the same hash at the
+  // same frame; a divergence pinpoints where an optimization changed the
+  // game's outcome.
+  std::uint64_t stateHash();
+
 private:
 
-  Id &getCell(int x, int y) { return grid[y * conf.gridWidth + x]; }
+  // Freeze the current players into a new snapshot for readers
+  void publishSnapshot() {
+    auto frozen = std::make_shared<std::map<Id, Player>>();
+    players.forEach(
+        [&](Id id, const Player &player) { (*frozen)[id] = player; });
+    snapshot.store(frozen, std::memory_order_release);
+    auto &slot = renderBuffer.writeSlot();
+    slot.players = std::move(frozen);
+    slot.frame = frame;
+    slot.gameOver = gameStarted && players.size() <= 1;
+    renderBuffer.publish();
+  }
+
+  Id getCell(int x, int y) { return grid[y * conf.gridWidth + x]; }
+
+  void setCellIndex(sf::Uint32 index, Id value) {
+    grid[index] = value;
+    if (value) {
+      occupancy[index >> 6] |= std::uint64_t(1) << (index & 63);
+    } else {
+      occupancy[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+    }
+    dirtyCells.push_back(index);
+  }
+
+  void setCell(int x, int y, Id value) {
+    setCellIndex(y * conf.gridWidth + x, value);
+  }
+
+  // Pick a uniformly random free cell by scanning the occupancy words,
+  // O(grid words) regardless of how full the grid is
+  sf::Vector2i sampleFreeCell();
+
+  // The per-tick hot path, instantiated once per whitelisted grid size via
+  // withGridShape so every `y * width + x` in it folds to shift/add
+  template <typename Shape>
+  void movePlayersOn(Shape shape, const std::map<Id, Direction> &directions);
 
-  bool legalMove(sf::Vector2i newPos);
+  template <typename Shape> bool legalMove(Shape shape, sf::Vector2i newPos);
 
-  std::set<Id> checkCollisions(std::map<Id, sf::Vector2i> newPositions);
+  template <typename Shape>
+  TickVector<Id>
+  checkCollisions(Shape shape,
+                  const TickVector<std::pair<Id, sf::Vector2i>> &newPositions);
 
 };
 
@@ -0,0 +1,51 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <cstddef>
+
+namespace cycles_server {
+
+/**
+ * @brief Grid dimensions known at compile time
+ *
+ * With the width a literal, `y * width + x` constant-folds to shift/add and
+ * the compiler can unroll and vectorize sweeps over whole rows, which it
+ * cannot do when the width is loaded from Configuration every iteration.
+ */
+template <int W, int H> struct FixedShape {
+  static constexpr int width() { return W; }
+  static constexpr int height() { return H; }
+  static constexpr std::size_t cells() { return std::size_t(W) * H; }
+  static constexpr sf::Uint32 index(int x, int y) { return y * W + x; }
+};
+
+/// Fallback for grid sizes outside the deployment whitelist
+struct RuntimeShape {
+  int w;
+  int h;
+  int width() const { return w; }
+  int height() const { return h; }
+  std::size_t cells() const { return std::size_t(w) * h; }
+  sf::Uint32 index(int x, int y) const { return y * w + x; }
+};
+
+/**
+ * @brief Run a callable with this grid's shape as a compile-time type
+ *
+ * Deployments run on a fixed grid size for a whole season, so the hot loops
+ * are instantiated once per whitelisted size (the shipped config and the
+ * built-in default) and the dispatch is two integer compares per call.
+ * Unlisted sizes take the runtime-width instantiation and behave
+ * identically.
+ */
+template <typename F>
+decltype(auto) withGridShape(int width, int height, F &&f) {
+  if (width == 100 && height == 80) {
+    return f(FixedShape<100, 80>{});
+  }
+  if (width == 100 && height == 100) {
+    return f(FixedShape<100, 100>{});
+  }
+  return f(RuntimeShape{width, height});
+}
+
+} // namespace cycles_server
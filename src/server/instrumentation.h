@@ -0,0 +1,133 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cycles_server {
+
+/**
+ * @brief Rolling per-stage timing statistics for the game loop
+ *
+ * Each tick stage records its duration into a fixed-size rolling window, so
+ * when a tick overruns its budget we can tell which stage ate it. Readers
+ * (the HUD overlay and the CSV exporter) query p50/p99/max over the window.
+ * Recording is a mutex-guarded push into a preallocated ring, cheap enough
+ * to leave on in production matches.
+ */
+class TickStats {
+public:
+  enum Stage {
+    CheckPlayers = 0,
+    BuildPackets,
+    Communicate,
+    MovePlayers,
+    WholeTick,
+    StageCount
+  };
+
+  static const char *stageName(Stage stage) {
+    static constexpr const char *names[StageCount] = {
+        "checkPlayers", "buildPackets", "communicate", "movePlayers", "tick"};
+    return names[stage];
+  }
+
+  struct Summary {
+    float p50 = 0;
+    float p99 = 0;
+    float max = 0;
+  };
+
+  void record(Stage stage, float milliseconds) {
+    std::scoped_lock lock(statsMutex);
+    auto &data = stages[stage];
+    if (data.samples.size() < windowSize) {
+      data.samples.push_back(milliseconds);
+    } else {
+      data.samples[data.next] = milliseconds;
+    }
+    data.next = (data.next + 1) % windowSize;
+    data.max = std::max(data.max, milliseconds);
+  }
+
+  Summary summarize(Stage stage) const {
+    std::scoped_lock lock(statsMutex);
+    const auto &data = stages[stage];
+    if (data.samples.empty()) {
+      return {};
+    }
+    auto sorted = data.samples;
+    std::sort(sorted.begin(), sorted.end());
+    Summary summary;
+    summary.p50 = sorted[sorted.size() / 2];
+    summary.p99 = sorted[(sorted.size() * 99) / 100];
+    summary.max = data.max;
+    return summary;
+  }
+
+  // One-line overview for the renderer banner
+  std::string hudLine() const {
+    const auto tick = summarize(WholeTick);
+    const auto comm = summarize(Communicate);
+    const auto move = summarize(MovePlayers);
+    char line[128];
+    std::snprintf(line, sizeof(line),
+                  "Tick p50 %.1f p99 %.1f max %.1f ms (comm %.1f, move %.2f)",
+                  tick.p50, tick.p99, tick.max, comm.p99, move.p99);
+    return line;
+  }
+
+  void writeCsvHeader(std::ostream &out) const {
+    out << "frame,clients,stage,p50_ms,p99_ms,max_ms\n";
+  }
+
+  void writeCsvRow(std::ostream &out, int frame, size_t clients) const {
+    for (int stage = 0; stage < StageCount; stage++) {
+      const auto summary = summarize(static_cast<Stage>(stage));
+      out << frame << ',' << clients << ','
+          << stageName(static_cast<Stage>(stage)) << ',' << summary.p50 << ','
+          << summary.p99 << ',' << summary.max << '\n';
+    }
+    out.flush();
+  }
+
+private:
+  static constexpr size_t windowSize = 256;
+
+  struct StageData {
+    std::vector<float> samples;
+    size_t next = 0;
+    float max = 0;
+  };
+
+  std::array<StageData, StageCount> stages;
+  mutable std::mutex statsMutex;
+};
+
+/**
+ * @brief Scoped timer recording the lifetime of a tick stage into TickStats
+ */
+class StageTimer {
+  TickStats &stats;
+  TickStats::Stage stage;
+  std::chrono::steady_clock::time_point start;
+
+public:
+  StageTimer(TickStats &stats, TickStats::Stage stage)
+      : stats(stats), stage(stage), start(std::chrono::steady_clock::now()) {}
+
+  StageTimer(const StageTimer &) = delete;
+  StageTimer &operator=(const StageTimer &) = delete;
+
+  ~StageTimer() {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    stats.record(stage,
+                 std::chrono::duration<float, std::milli>(elapsed).count());
+  }
+};
+
+} // namespace cycles_server
@@ -77,6 +77,9 @@ GameRenderer::GameRenderer(Configuration conf)
 }
 
 void GameRenderer::render(std::shared_ptr<Game> game) {
+  // One wait-free read per frame: the game loop publishes into a triple
+  // buffer, so a slow GPU frame can never hold up a tick
+  const auto &snapshot = game->getRenderSnapshot();
   window.clear(sf::Color::Black);
   // // Draw grid
   // sf::RectangleShape cell(sf::Vector2f(conf.cellSize - 1, conf.cellSize -
@@ -87,11 +90,11 @@ void GameRenderer::render(std::shared_ptr<Game> game) {
   // 	window.draw(cell);
   //   }
   // }
-  renderPlayers(game);
-  if (game->isGameOver()) {
-    renderGameOver(game);
+  renderPlayers(snapshot);
+  if (snapshot.gameOver) {
+    renderGameOver(snapshot);
   }
-  renderBanner(game);
+  renderBanner(snapshot);
   window.display();
 }
 
@@ -112,7 +115,7 @@ void GameRenderer::handleEvents(
   }
 }
 
-void GameRenderer::renderPlayers(std::shared_ptr<Game> game) {
+void GameRenderer::renderPlayers(const RenderSnapshot &snapshot) {
   const int offset_y = conf.gameBannerHeight + 0;
   const int offset_x = 0;
   auto cellSize = conf.cellSize;
@@ -122,60 +125,78 @@ void GameRenderer::renderPlayers(std::shared_ptr<Game> game) {
   bkg.setFillColor(sf::Color::Black);
   renderTexture.draw(bkg);
 
-  for (const auto &[id, player] : game->getPlayers()) {
-    sf::CircleShape playerShape(cellSize);
-    // Make the head of the player darker
+  const auto &players = snapshot.players;
+  // Batch every cell into one vertex array (one quad per cell, color per
+  // vertex) so the whole board is a single draw call instead of one draw
+  // per tail cell
+  size_t cells = 0;
+  for (const auto &[id, player] : *players) {
+    cells += player.tail.size() + 2; // tail + head halo + head
+  }
+  cellQuads.resize(cells * 4);
+  size_t vertex = 0;
+  auto appendQuad = [&](float x, float y, float size, sf::Color color) {
+    cellQuads[vertex++] = sf::Vertex(sf::Vector2f(x, y), color);
+    cellQuads[vertex++] = sf::Vertex(sf::Vector2f(x + size, y), color);
+    cellQuads[vertex++] = sf::Vertex(sf::Vector2f(x + size, y + size), color);
+    cellQuads[vertex++] = sf::Vertex(sf::Vector2f(x, y + size), color);
+  };
+  for (const auto &[id, player] : *players) {
+    for (auto tail : player.tail) {
+      appendQuad(tail.x * cellSize + offset_x, tail.y * cellSize + offset_y,
+                 cellSize, player.color);
+    }
+    // Make the head of the player darker, with a halo in the tail color
     auto darkerColor = player.color;
     darkerColor.r = darkerColor.r * 0.8;
     darkerColor.g = darkerColor.g * 0.8;
     darkerColor.b = darkerColor.b * 0.8;
-    playerShape.setFillColor(darkerColor);
-    playerShape.setPosition(
-        (player.position.x) * cellSize - cellSize / 2 + offset_x,
-        (player.position.y) * cellSize - cellSize / 2 + offset_y);
-    renderTexture.draw(playerShape);
-    // Add a border to the head
-    sf::CircleShape borderShape(cellSize + 1);
-    borderShape.setFillColor(sf::Color::Transparent);
-    borderShape.setOutlineThickness(3);
-    borderShape.setOutlineColor(player.color);
-    borderShape.setPosition(
-        (player.position.x) * cellSize - cellSize / 2 - 1 + offset_x,
-        (player.position.y) * cellSize - cellSize / 2 - 1 + offset_y);
-    renderTexture.draw(borderShape);
-    // Draw tail
-    for (auto tail : player.tail) {
-      sf::RectangleShape tailShape(sf::Vector2f(cellSize, cellSize));
-      tailShape.setFillColor(player.color);
-      tailShape.setPosition(tail.x * cellSize + offset_x,
-                            tail.y * cellSize + offset_y);
-      renderTexture.draw(tailShape);
-    }
+    appendQuad(player.position.x * cellSize - 3 + offset_x,
+               player.position.y * cellSize - 3 + offset_y, cellSize + 6,
+               player.color);
+    appendQuad(player.position.x * cellSize + offset_x,
+               player.position.y * cellSize + offset_y, cellSize, darkerColor);
   }
+  renderTexture.draw(cellQuads);
   renderTexture.display();
   if (postProcess)
     postProcess->apply(window, renderTexture);
   else
     window.draw(sf::Sprite(renderTexture.getTexture()));
-  for (const auto &[id, player] : game->getPlayers()) {
-    sf::Text nameText(player.name, font, 30);
-    nameText.setFillColor(sf::Color::White);
-    nameText.setOutlineThickness(2);
-    nameText.setOutlineColor(sf::Color::Black);
+  // Name labels are cached per player; only the position changes per frame
+  for (auto it = nameTexts.begin(); it != nameTexts.end();) {
+    if (players->find(it->first) == players->end()) {
+      it = nameTexts.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (const auto &[id, player] : *players) {
+    auto [it, inserted] = nameTexts.try_emplace(id);
+    auto &nameText = it->second;
+    if (inserted) {
+      nameText.setFont(font);
+      nameText.setString(player.name);
+      nameText.setCharacterSize(30);
+      nameText.setFillColor(sf::Color::White);
+      nameText.setOutlineThickness(2);
+      nameText.setOutlineColor(sf::Color::Black);
+    }
     nameText.setPosition(player.position.x * cellSize - 20 + offset_x,
                          player.position.y * cellSize - 20 + offset_y);
     window.draw(nameText);
   }
 }
 
-void GameRenderer::renderGameOver(std::shared_ptr<Game> game) {
+void GameRenderer::renderGameOver(const RenderSnapshot &snapshot) {
   sf::Text gameOverText("Game Over", font, 60);
   gameOverText.setOutlineThickness(3);
   gameOverText.setOutlineColor(sf::Color::White);
   gameOverText.setFillColor(sf::Color::Black);
   gameOverText.setPosition(conf.gameWidth / 2 - 150, conf.gameHeight / 2 - 30);
-  if (game->getPlayers().size() > 0) {
-    auto winner = game->getPlayers().begin()->second.name;
+  const auto &players = snapshot.players;
+  if (players->size() > 0) {
+    auto winner = players->begin()->second.name;
     sf::Text winnerText("Winner: " + winner, font, 40);
     winnerText.setFillColor(sf::Color::Black);
     winnerText.setOutlineThickness(3);
@@ -186,7 +207,7 @@ void GameRenderer::renderGameOver(std::shared_ptr<Game> game) {
   window.draw(gameOverText);
 }
 
-void GameRenderer::renderBanner(std::shared_ptr<Game> game) {
+void GameRenderer::renderBanner(const RenderSnapshot &snapshot) {
   // Draw a banner at the top
   sf::RectangleShape banner(
       sf::Vector2f(conf.gameWidth, conf.gameBannerHeight - 20));
@@ -194,22 +215,30 @@ void GameRenderer::renderBanner(std::shared_ptr<Game> game) {
   banner.setPosition(0, 0);
   window.draw(banner);
   // Draw the frame number
-  sf::Text frameText("Frame: " + std::to_string(game->getFrame()), font, 22);
+  sf::Text frameText("Frame: " + std::to_string(snapshot.frame), font, 22);
   frameText.setPosition(10, 10);
   frameText.setFillColor(sf::Color::White);
   window.draw(frameText);
   // Draw the number of players
-  sf::Text playersText("Players: " + std::to_string(game->getPlayers().size()),
-                       font, 22);
+  sf::Text playersText(
+      "Players: " + std::to_string(snapshot.players->size()), font, 22);
   playersText.setPosition(10, 40);
   playersText.setFillColor(sf::Color::White);
   window.draw(playersText);
+  // Draw the tick timing overview
+  if (tickStats) {
+    sf::Text statsText(tickStats->hudLine(), font, 22);
+    statsText.setPosition(250, 10);
+    statsText.setFillColor(sf::Color::White);
+    window.draw(statsText);
+  }
 }
 
 void GameRenderer::renderSplashScreen(std::shared_ptr<Game> game) {
+  const auto &snapshot = game->getRenderSnapshot();
   window.clear(sf::Color::Black);
-  renderPlayers(game);
-  renderBanner(game);
+  renderPlayers(snapshot);
+  renderBanner(snapshot);
   sf::Text splashText("Waiting for players\npress SPACE to start", font, 30);
   splashText.setFillColor(sf::Color::Black);
   splashText.setOutlineThickness(2);
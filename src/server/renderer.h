@@ -1,8 +1,10 @@
 #pragma once
 #include"server.h"
 #include "game_logic.h"
+#include "instrumentation.h"
 #include <SFML/Graphics.hpp>
 #include <functional>
+#include <map>
 
 
 namespace cycles_server{
@@ -36,11 +38,21 @@ public:
 
   void renderSplashScreen(std::shared_ptr<Game> game);
 
+  // Show per-stage tick timings in the banner, next to the frame counter
+  void setTickStats(std::shared_ptr<TickStats> stats) { tickStats = stats; }
+
 private:
-  void renderPlayers(std::shared_ptr<Game> game);
+  std::shared_ptr<TickStats> tickStats;
+  // One quad per tail/head cell, rebuilt in place each frame and submitted
+  // in a single draw call instead of one draw per cell
+  sf::VertexArray cellQuads{sf::Quads};
+  // Name labels cached across frames; glyph layout only happens on join
+  std::map<Id, sf::Text> nameTexts;
+
+  void renderPlayers(const RenderSnapshot &snapshot);
 
-  void renderGameOver(std::shared_ptr<Game> game);
+  void renderGameOver(const RenderSnapshot &snapshot);
 
-  void renderBanner(std::shared_ptr<Game> game);
+  void renderBanner(const RenderSnapshot &snapshot);
 };
 }
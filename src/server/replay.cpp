@@ -0,0 +1,199 @@
+#include "replay.h"
+#include "game_logic.h"
+#include <cstring>
+#include <spdlog/spdlog.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cycles_server {
+
+namespace {
+
+constexpr char replayMagic[4] = {'C', 'Y', 'R', 'P'};
+constexpr std::uint32_t replayVersion = 1;
+
+enum RecordType : std::uint8_t { JoinRecord = 0, LeaveRecord = 1, TickRecord = 2 };
+
+template <typename T> void writeRaw(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+} // namespace
+
+bool ReplayRecorder::open(const std::string &path, const Configuration &conf) {
+  out.open(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    spdlog::error("Failed to open replay file: {}", path);
+    return false;
+  }
+  out.write(replayMagic, sizeof(replayMagic));
+  writeRaw(out, replayVersion);
+  writeRaw(out, static_cast<std::uint32_t>(conf.gridWidth));
+  writeRaw(out, static_cast<std::uint32_t>(conf.gridHeight));
+  return true;
+}
+
+void ReplayRecorder::recordJoin(Id id, const std::string &name,
+                                sf::Vector2i position) {
+  writeRaw(out, static_cast<std::uint8_t>(JoinRecord));
+  writeRaw(out, id);
+  writeRaw(out, static_cast<std::uint32_t>(name.size()));
+  out.write(name.data(), name.size());
+  writeRaw(out, static_cast<std::int32_t>(position.x));
+  writeRaw(out, static_cast<std::int32_t>(position.y));
+}
+
+void ReplayRecorder::recordLeave(Id id) {
+  writeRaw(out, static_cast<std::uint8_t>(LeaveRecord));
+  writeRaw(out, id);
+}
+
+void ReplayRecorder::recordTick(int frame,
+                                const std::map<Id, Direction> &directions) {
+  writeRaw(out, static_cast<std::uint8_t>(TickRecord));
+  writeRaw(out, static_cast<std::int32_t>(frame));
+  writeRaw(out, static_cast<std::uint8_t>(directions.size()));
+  for (const auto &[id, direction] : directions) {
+    writeRaw(out, id);
+    writeRaw(out, static_cast<std::uint8_t>(cycles::getDirectionValue(direction)));
+  }
+  out.flush();
+}
+
+ReplayPlayer::~ReplayPlayer() {
+#ifndef _WIN32
+  if (mapping != nullptr) {
+    munmap(mapping, mappingSize);
+  }
+#endif
+}
+
+bool ReplayPlayer::open(const std::string &path) {
+#ifndef _WIN32
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    spdlog::error("Failed to open replay file: {}", path);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  mappingSize = static_cast<size_t>(st.st_size);
+  mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    spdlog::error("Failed to map replay file: {}", path);
+    return false;
+  }
+  data = static_cast<const std::uint8_t *>(mapping);
+  size = mappingSize;
+#else
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    spdlog::error("Failed to open replay file: {}", path);
+    return false;
+  }
+  fallback.assign(std::istreambuf_iterator<char>(in),
+                  std::istreambuf_iterator<char>());
+  data = fallback.data();
+  size = fallback.size();
+#endif
+  if (size < sizeof(replayMagic) + 3 * sizeof(std::uint32_t) ||
+      std::memcmp(data, replayMagic, sizeof(replayMagic)) != 0) {
+    spdlog::error("Not a replay file: {}", path);
+    return false;
+  }
+  cursor = sizeof(replayMagic);
+  std::uint32_t version;
+  std::memcpy(&version, data + cursor, sizeof(version));
+  cursor += sizeof(version);
+  if (version != replayVersion) {
+    spdlog::error("Unsupported replay version {} in {}", version, path);
+    return false;
+  }
+  std::uint32_t w, h;
+  std::memcpy(&w, data + cursor, sizeof(w));
+  cursor += sizeof(w);
+  std::memcpy(&h, data + cursor, sizeof(h));
+  cursor += sizeof(h);
+  width = static_cast<int>(w);
+  height = static_cast<int>(h);
+  return true;
+}
+
+int ReplayPlayer::run(Game &game) {
+  int ticks = 0;
+  std::map<Id, Direction> directions;
+  auto fits = [&](size_t bytes) { return cursor + bytes <= size; };
+  while (fits(1)) {
+    const auto type = data[cursor++];
+    switch (type) {
+    case JoinRecord: {
+      if (!fits(1 + sizeof(std::uint32_t))) {
+        return ticks;
+      }
+      const Id recordedId = data[cursor++];
+      std::uint32_t nameLen;
+      std::memcpy(&nameLen, data + cursor, sizeof(nameLen));
+      cursor += sizeof(nameLen);
+      if (!fits(nameLen + 2 * sizeof(std::int32_t))) {
+        return ticks;
+      }
+      std::string name(reinterpret_cast<const char *>(data + cursor), nameLen);
+      cursor += nameLen;
+      std::int32_t x, y;
+      std::memcpy(&x, data + cursor, sizeof(x));
+      cursor += sizeof(x);
+      std::memcpy(&y, data + cursor, sizeof(y));
+      cursor += sizeof(y);
+      const Id id = game.addPlayer(name, sf::Vector2i(x, y));
+      if (id != recordedId) {
+        spdlog::warn("Replay: player {} got id {} instead of recorded {}",
+                     name, id, recordedId);
+      }
+      break;
+    }
+    case LeaveRecord: {
+      if (!fits(1)) {
+        return ticks;
+      }
+      game.removePlayer(data[cursor++]);
+      break;
+    }
+    case TickRecord: {
+      if (!fits(sizeof(std::int32_t) + 1)) {
+        return ticks;
+      }
+      std::int32_t frame;
+      std::memcpy(&frame, data + cursor, sizeof(frame));
+      cursor += sizeof(frame);
+      const auto count = data[cursor++];
+      if (!fits(static_cast<size_t>(count) * 2)) {
+        return ticks;
+      }
+      directions.clear();
+      for (int i = 0; i < count; i++) {
+        const Id id = data[cursor++];
+        directions[id] = cycles::getDirectionFromValue(data[cursor++]);
+      }
+      game.setFrame(frame);
+      game.movePlayers(directions);
+      ticks++;
+      break;
+    }
+    default:
+      spdlog::error("Replay: unknown record type {}", type);
+      return ticks;
+    }
+  }
+  return ticks;
+}
+
+} // namespace cycles_server
@@ -0,0 +1,71 @@
+#pragma once
+#include "server.h"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cycles_server {
+
+class Game;
+
+/**
+ * @brief Append-only recorder for the inputs that drive a match
+ *
+ * Records join/leave events and each tick's sanitized direction map as
+ * fixed-layout binary records, so a finished match can be re-simulated
+ * deterministically and the file can be memory-mapped without parsing
+ * overhead. Everything else (collisions, deaths) is reproduced by feeding
+ * the stream back through Game.
+ */
+class ReplayRecorder {
+  std::ofstream out;
+
+public:
+  // Truncates the file and writes the header; returns false on failure
+  bool open(const std::string &path, const Configuration &conf);
+
+  bool isOpen() const { return out.is_open(); }
+
+  void recordJoin(Id id, const std::string &name, sf::Vector2i position);
+
+  void recordLeave(Id id);
+
+  void recordTick(int frame, const std::map<Id, Direction> &directions);
+};
+
+/**
+ * @brief Memory-maps a replay file and feeds it into a fresh Game
+ *
+ * No sockets, no renderer: run() re-simulates the exact recorded tick
+ * sequence, which makes replays profiling targets and input corpora for
+ * the benchmark suite.
+ */
+class ReplayPlayer {
+  const std::uint8_t *data = nullptr;
+  size_t size = 0;
+  size_t cursor = 0;
+  void *mapping = nullptr;
+  size_t mappingSize = 0;
+  std::vector<std::uint8_t> fallback; // platforms without mmap
+  int width = 0;
+  int height = 0;
+
+public:
+  ReplayPlayer() = default;
+  ReplayPlayer(const ReplayPlayer &) = delete;
+  ReplayPlayer &operator=(const ReplayPlayer &) = delete;
+  ~ReplayPlayer();
+
+  bool open(const std::string &path);
+
+  int gridWidth() const { return width; }
+
+  int gridHeight() const { return height; }
+
+  // Replays every recorded event into the game; returns the tick count
+  int run(Game &game);
+};
+
+} // namespace cycles_server
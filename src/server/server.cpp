@@ -1,7 +1,17 @@
 #include "server.h"
 #include "game_logic.h"
+#include "instrumentation.h"
+#include "protocol.h"
 #include "renderer.h"
+#include "replay.h"
+#include "spsc_queue.h"
 #include <SFML/Network.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -12,89 +22,356 @@
 
 using namespace cycles_server;
 
+// A small persistent thread pool that fans one tick's snapshot sends out
+// across the client sockets. The dispatching thread participates in the
+// batch and run() returns once every task finished, so results can be
+// folded back into the tick's bookkeeping right after.
+class SendPool {
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable taskCv;
+  std::condition_variable doneCv;
+  std::vector<std::function<void()>> *tasks = nullptr;
+  std::atomic<size_t> nextTask{0};
+  size_t completed = 0;
+  size_t activeWorkers = 0; // workers currently inside workOn
+  std::uint64_t generation = 0;
+  bool stopping = false;
+
+public:
+  explicit SendPool(size_t threadCount) {
+    for (size_t i = 0; i < threadCount; i++) {
+      workers.emplace_back(&SendPool::workerLoop, this);
+    }
+  }
+
+  ~SendPool() {
+    {
+      std::scoped_lock lock(mutex);
+      stopping = true;
+    }
+    taskCv.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  // Run every task in the batch, returning when all of them are done
+  void run(std::vector<std::function<void()>> &batch) {
+    if (batch.empty()) {
+      return;
+    }
+    {
+      std::scoped_lock lock(mutex);
+      tasks = &batch;
+      nextTask = 0;
+      completed = 0;
+      generation++;
+    }
+    taskCv.notify_all();
+    workOn(batch);
+    // Wait until every task ran and every worker has stepped out of the
+    // batch, so the caller is free to clear and rebuild it immediately
+    std::unique_lock lock(mutex);
+    doneCv.wait(lock,
+                [&] { return completed == batch.size() && activeWorkers == 0; });
+    tasks = nullptr;
+  }
+
+private:
+  void workOn(std::vector<std::function<void()>> &batch) {
+    while (true) {
+      const size_t index = nextTask.fetch_add(1);
+      if (index >= batch.size()) {
+        return;
+      }
+      batch[index]();
+      std::scoped_lock lock(mutex);
+      completed++;
+      if (completed == batch.size()) {
+        doneCv.notify_all();
+      }
+    }
+  }
+
+  void workerLoop() {
+    std::uint64_t seen = 0;
+    while (true) {
+      std::vector<std::function<void()>> *batch;
+      {
+        std::unique_lock lock(mutex);
+        // The live-batch check matters: a worker scheduled only after the
+        // dispatcher finished the whole generation must keep waiting, not
+        // chase a pointer run() already retired
+        taskCv.wait(lock, [&] {
+          return stopping || (tasks != nullptr && generation != seen);
+        });
+        if (stopping) {
+          return;
+        }
+        seen = generation;
+        batch = tasks;
+        activeWorkers++;
+      }
+      workOn(*batch);
+      {
+        std::scoped_lock lock(mutex);
+        activeWorkers--;
+        if (activeWorkers == 0) {
+          doneCv.notify_all();
+        }
+      }
+    }
+  }
+};
+
 // Server Logic
 class GameServer {
   sf::TcpListener listener;
   std::map<Id, std::shared_ptr<sf::TcpSocket>> clientSockets;
-  std::mutex serverMutex;
   std::shared_ptr<Game> game;
   const Configuration conf;
-  bool running;
+  // Written by stop() and read by the tick thread, so it must be atomic
+  std::atomic<bool> running;
 
 public:
-  GameServer(std::shared_ptr<Game> game, Configuration conf)
+  // With listen = false the server never touches the port; a tournament
+  // host accepts connections itself and hands the sockets over through
+  // registerClient
+  GameServer(std::shared_ptr<Game> game, Configuration conf, bool listen = true)
       : game(game), conf(conf), running(false) {
-    const char *portenv = std::getenv("CYCLES_PORT");
-    if (portenv == nullptr) {
-      spdlog::critical("Please set the CYCLES_PORT environment variable");
-      exit(1);
+    if (listen) {
+      const char *portenv = std::getenv("CYCLES_PORT");
+      if (portenv == nullptr) {
+        spdlog::critical("Please set the CYCLES_PORT environment variable");
+        exit(1);
+      }
+      spdlog::info("Listening on port {}", portenv);
+      const unsigned short PORT = std::stoi(portenv);
+      listener.listen(PORT);
+      listener.setBlocking(false);
+      if (listener.getLocalPort() == 0) {
+        spdlog::critical("Failed to bind to port {}", PORT);
+        exit(1);
+      }
     }
-    spdlog::info("Listening on port {}", portenv);
-    const unsigned short PORT = std::stoi(portenv);
-    listener.listen(PORT);
-    listener.setBlocking(false);
-    if (listener.getLocalPort() == 0) {
-      spdlog::critical("Failed to bind to port {}", PORT);
-      exit(1);
+    if (!conf.replayFile.empty()) {
+      replayRecorder.open(conf.replayFile, conf);
+    }
+    if (!conf.statsCsv.empty()) {
+      statsCsvStream.open(conf.statsCsv);
+      if (statsCsvStream.is_open()) {
+        tickStats->writeCsvHeader(statsCsvStream);
+      } else {
+        spdlog::error("Failed to open tick stats CSV file: {}", conf.statsCsv);
+      }
     }
   }
 
   void run() {
     running = true;
+    broadcasting = true;
+    std::thread broadcastThread(&GameServer::spectatorLoop, this);
     std::thread gameLoopThread(&GameServer::gameLoop, this);
     gameLoopThread.join();
+    broadcasting = false;
+    broadcastThread.join();
   }
 
   void stop() { running = false; }
 
+  // Shut the accept thread down; until then it keeps admitting spectators
+  // even after player acceptance closed
+  void stopAccepting() {
+    acceptingClients = false;
+    acceptorRunning = false;
+  }
+
   int getFrame() const { return frame; }
 
+  size_t getClientCount() { return clientCount.load(); }
+
+  std::shared_ptr<TickStats> getTickStats() { return tickStats; }
+
   void setAcceptingClients(bool accepting) { acceptingClients = accepting; }
 
+  // Runs on its own thread until stopAccepting. Handshakes are only parsed
+  // here; player registrations are mailed to whichever thread drives the
+  // match (the lobby loop before the start, the tick thread after) and
+  // spectators to the broadcast thread, so this thread never touches the
+  // tick's data structures and the tick never waits on it.
   void acceptClients() {
-    while (acceptingClients &&
-           static_cast<int>(clientSockets.size()) < conf.maxClients) {
+    while (acceptorRunning) {
       auto clientSocket = std::make_shared<sf::TcpSocket>();
-      if (listener.accept(*clientSocket) == sf::Socket::Done) {
-        clientSocket->setBlocking(
-            true); // Set to blocking for initial communication
-        // Receive player name
-        sf::Packet namePacket;
-        if (clientSocket->receive(namePacket) == sf::Socket::Done) {
-          std::string playerName;
-          namePacket >> playerName;
-          auto id = game->addPlayer(playerName);
-          // Send color to the client
-          sf::Packet colorPacket;
-          const auto &player = game->getPlayers().at(id);
-          colorPacket << player.color.r << player.color.g << player.color.b;
-          if (clientSocket->send(colorPacket) != sf::Socket::Done) {
-            spdlog::critical("Failed to send color to client: {}", playerName);
-          } else {
-            spdlog::info("Color sent to client: {}", playerName);
-          }
-          clientSocket->setBlocking(
-              false); // Set back to non-blocking for game loop
-          clientSockets[id] = clientSocket;
-          spdlog::info("New client connected: {} with id {}", playerName, id);
-        }
+      if (listener.accept(*clientSocket) != sf::Socket::Done) {
+        sf::sleep(sf::milliseconds(5));
+        continue;
+      }
+      clientSocket->setBlocking(
+          true); // Set to blocking for initial communication
+      // Receive player name
+      sf::Packet namePacket;
+      if (clientSocket->receive(namePacket) != sf::Socket::Done) {
+        continue;
+      }
+      std::string playerName;
+      namePacket >> playerName;
+      // Optional feature byte; old clients send just the name and stay
+      // on the raw wire format
+      sf::Uint8 requestedFeatures = 0;
+      std::string matchToken;
+      unsigned short udpPort = 0;
+      if (!namePacket.endOfPacket()) {
+        namePacket >> requestedFeatures;
+      }
+      if (!namePacket.endOfPacket()) {
+        namePacket >> matchToken; // only tournament hosts route by it
+      }
+      if (!namePacket.endOfPacket()) {
+        namePacket >> udpPort;
       }
+      // Viewers bypass the player gate entirely: they may join mid-match
+      // and count against their own cap
+      if (requestedFeatures & cycles::protocol::Spectator) {
+        admitSpectator(clientSocket);
+        continue;
+      }
+      if (!acceptingClients ||
+          static_cast<int>(clientCount.load()) >= conf.maxClients) {
+        clientSocket->disconnect();
+        continue;
+      }
+      while (!joinMailbox.push(
+          {clientSocket, playerName, requestedFeatures, udpPort})) {
+        // Mailbox full: the consumer drains every frame, back off briefly
+        sf::sleep(sf::milliseconds(1));
+      }
+    }
+  }
+
+  // Drain the join mailbox. Called only from the thread currently driving
+  // the match, at tick (or lobby-poll) boundaries.
+  void processJoins() {
+    PendingJoin join;
+    while (joinMailbox.pop(join)) {
+      registerClient(join.socket, join.name, join.requestedFeatures,
+                     join.udpPort);
     }
   }
 
+  // Add a handshaken client to this match: spawn its player, reply with the
+  // color and accepted features, and set up the per-tick bookkeeping. The
+  // socket must already be past the name packet.
+  void registerClient(std::shared_ptr<sf::TcpSocket> clientSocket,
+                      const std::string &playerName,
+                      sf::Uint8 requestedFeatures, unsigned short udpPort) {
+    sf::Uint8 accepted =
+        cycles::protocol::CompressedGrids | cycles::protocol::UdpSnapshots;
+    if (conf.interestRadius > 0) {
+      accepted |= cycles::protocol::WindowedSnapshots;
+    }
+    sf::Uint8 features = requestedFeatures & accepted;
+    if (udpPort == 0) {
+      features &= ~cycles::protocol::UdpSnapshots;
+    }
+    if (features & cycles::protocol::WindowedSnapshots) {
+      // Window frames are small and self-contained, so they stay on TCP;
+      // the cumulative-delta machinery would resend the whole dirty set
+      // anyway
+      features &= ~cycles::protocol::UdpSnapshots;
+    }
+    auto id = game->addPlayer(playerName);
+    // Send color to the client, followed by the accepted features
+    sf::Packet colorPacket;
+    // Hold the snapshot so the player reference stays valid
+    auto players = game->getPlayerSnapshot();
+    const auto &player = players->at(id);
+    colorPacket << player.color.r << player.color.g << player.color.b
+                << features;
+    if (clientSocket->send(colorPacket) != sf::Socket::Done) {
+      spdlog::critical("Failed to send color to client: {}", playerName);
+    } else {
+      spdlog::info("Color sent to client: {}", playerName);
+    }
+    clientSocket->setBlocking(
+        false); // Set back to non-blocking for game loop
+    clientSockets[id] = clientSocket;
+    clientFeatures[id] = features;
+    clientUdpPorts[id] = udpPort;
+    clientCount.store(clientSockets.size());
+    clientSetDirty = true;
+    // The first state packet a client receives must be a full keyframe
+    clientsNeedingKeyframe.insert(id);
+    if (replayRecorder.isOpen()) {
+      replayRecorder.recordJoin(id, playerName,
+                                game->getPlayerSnapshot()->at(id).position);
+    }
+    spdlog::info("New client connected: {} with id {}", playerName, id);
+  }
+
 private:
   int frame = 0;
   const int max_client_communication_time = 50; // ms
+  const int udp_resend_interval = 10; // ms between datagram retransmits
+  const int keyframe_interval = 30; // frames between full-grid keyframes
 
-  bool acceptingClients = true;
+  // Flipped from the match-driving thread, read by the accept thread
+  std::atomic<bool> acceptingClients{true};
+  std::atomic<bool> acceptorRunning{true};
+  // A handshake parsed by the accept thread, waiting to be registered by
+  // the match-driving thread
+  struct PendingJoin {
+    std::shared_ptr<sf::TcpSocket> socket;
+    std::string name;
+    sf::Uint8 requestedFeatures = 0;
+    unsigned short udpPort = 0;
+  };
+  SpscQueue<PendingJoin, 256> joinMailbox;
+  // Registered clients, readable from any thread (lobby progress, the
+  // accept loop's capacity check) without touching the tick-owned maps
+  std::atomic<size_t> clientCount{0};
+  // Spectator tier. Viewers are read-only: the tick thread only serializes
+  // their feed (one packet per tick, shared by all of them); everything
+  // per-viewer lives on the broadcast thread.
+  SpscQueue<std::shared_ptr<sf::TcpSocket>, 64> spectatorMailbox;
+  std::atomic<size_t> spectatorCount{0};
+  std::atomic<bool> broadcasting{false};
+  struct SpectatorFeed {
+    sf::Packet packet;
+    int frame = -1;
+  };
+  TripleBuffer<SpectatorFeed> spectatorFeed;
+  std::set<Id> clientsNeedingKeyframe;
+  sf::Packet keyframePacket;
+  sf::Packet keyframePacketRle;
+  sf::Packet deltaPacket;
+  sf::Packet udpDeltaPacket;
+  // Shared head of every Window packet; the per-client window block is
+  // appended onto each client's own copy
+  sf::Packet windowBasePacket;
+  std::map<Id, sf::Uint8> clientFeatures;
+  std::map<Id, unsigned short> clientUdpPorts;
+  sf::UdpSocket udpSocket;
+  // Cells changed since the last periodic keyframe, for cumulative deltas
+  std::vector<sf::Uint32> dirtySinceKeyframe;
+  int lastKeyframeBuiltFrame = 0;
+  sf::Uint32 lastSentRosterVersion = 0;
+  SendPool sendPool{4};
+  std::vector<std::function<void()>> sendTasks;
+  bool keyframeFrame = true;
+  bool clientSetDirty = true;
+  sf::SocketSelector receiveSelector;
+  std::shared_ptr<TickStats> tickStats = std::make_shared<TickStats>();
+  std::ofstream statsCsvStream;
+  ReplayRecorder replayRecorder;
 
   void checkPlayers() {
     // Remove sockets from players that have died or disconnected
     spdlog::debug("Server ({}): Checking players", frame);
-    auto players = game->getPlayers();
+    auto players = game->getPlayerSnapshot();
     for (const auto &[id, socket] : clientSockets) {
       bool remove = false;
-      if (players.find(id) == players.end()) {
+      if (players->find(id) == players->end()) {
         spdlog::info("Player {} has died", id);
         remove = true;
       }
@@ -103,135 +380,743 @@ private:
         remove = true;
       }
       if (remove) {
+        // Only disconnects remove a live player; deaths already happened
+        // inside movePlayers and need no replay record
+        if (replayRecorder.isOpen() && players->find(id) != players->end()) {
+          replayRecorder.recordLeave(id);
+        }
         game->removePlayer(id);
         clientSockets.erase(id);
+        clientFeatures.erase(id);
+        clientUdpPorts.erase(id);
+        // A stale id left here would force a full keyframe every tick for
+        // the rest of the match
+        clientsNeedingKeyframe.erase(id);
+        clientCount.store(clientSockets.size());
+        clientSetDirty = true;
       }
     }
   }
 
-  auto receiveClientInput(auto clientSockets) {
-    spdlog::debug("Server ({}): Receiving client input from {} clients", frame,
-                  clientSockets.size());
-    if (clientSockets.size() == 0) {
-      return std::map<Id, Direction>();
-    }
-    std::map<Id, Direction> successful;
-    for (const auto &[id, clientSocket] : clientSockets) {
-      auto name = game->getPlayers().at(id).name;
-      spdlog::debug("Server ({}): Receiving input from player {} ({})", frame,
-                    id, name);
-      sf::Packet packet;
-      auto status = clientSocket->receive(packet);
-      if (status == sf::Socket::Done) {
-        int direction;
-        packet >> direction;
-        spdlog::debug("Received direction {} from player {} ({})", direction,
-                      id, name);
-        successful[id] = static_cast<Direction>(direction);
-      }
-    }
-    return successful;
+  // Per-client communication state for one tick. The vector is persistent
+  // and only rebuilt when a client joins or leaves, instead of copying the
+  // socket map every tick.
+  struct ClientIO {
+    Id id;
+    std::shared_ptr<sf::TcpSocket> socket;
+    sf::Uint8 features;
+    unsigned short udpPort;
+    enum class Phase { SendPending, ReceivePending, Done } phase;
+    // Per-client copy of the outgoing snapshot. sf::Packet keeps its
+    // partial-send progress inside the packet, so a packet mid-send to one
+    // client must never be handed to another; the buffer's capacity is
+    // reused across ticks.
+    sf::Packet sendPacket;
+    sf::Packet *sendSource = nullptr;
+    bool prepared = false;
+    bool udpSend = false;
+    sf::Int32 lastUdpSendMs = 0; ///< Tick-clock time of the last datagram
+    bool windowed = false;
+    sf::Vector2i windowCenter; ///< This client's head, the window's center
+    sf::Socket::Status sendStatus = sf::Socket::NotReady;
+  };
+
+  std::vector<ClientIO> clientIO;
+
+  void syncClientIO() {
+    if (!clientSetDirty) {
+      return;
+    }
+    clientIO.clear();
+    clientIO.reserve(clientSockets.size());
+    for (const auto &[id, socket] : clientSockets) {
+      clientIO.push_back({id, socket, clientFeatures[id], clientUdpPorts[id],
+                          ClientIO::Phase::Done});
+    }
+    clientSetDirty = false;
   }
 
-  auto sendGameState(auto clientSockets) {
-    spdlog::debug("Server ({}): Sending game state to {} clients", frame,
-                  clientSockets.size());
-    if (clientSockets.size() == 0) {
-      return std::vector<Id>();
+  // Serialize the game state once per tick: a keyframe with the full grid
+  // when due (or when a client still needs one), and a delta carrying only
+  // the cells dirtied since the previous tick otherwise.
+  void buildGameStatePackets() {
+    const auto &grid = game->getGrid();
+    auto players = game->getPlayerSnapshot();
+    auto dirty = game->takeDirtyCells();
+    keyframeFrame = frame % keyframe_interval == 0;
+    // Names and colors are immutable after a join, so the roster block goes
+    // out only in keyframes and on frames where the set of players changed;
+    // every other frame carries just ids and positions
+    const auto rosterVersion = game->getRosterVersion();
+    // Spectators share one feed: RLE keyframes on keyframe frames,
+    // cumulative deltas otherwise, so their packets must exist whenever a
+    // viewer is connected even if no player negotiated those features
+    const bool spectatorsActive = spectatorCount.load() > 0;
+    // The cells changed since the last periodic keyframe back the cumulative
+    // deltas sent over UDP
+    dirtySinceKeyframe.insert(dirtySinceKeyframe.end(), dirty.begin(),
+                              dirty.end());
+    if (keyframeFrame) {
+      dirtySinceKeyframe.clear();
+      lastKeyframeBuiltFrame = frame;
     }
-    sf::Packet packet;
-    packet << conf.gridWidth << conf.gridHeight;
+    // Everything after the kind byte (and, for cumulative deltas, the base
+    // keyframe frame) is shared between the packet kinds
+    auto writeBody = [&](sf::Packet &packet, bool includeRoster) {
+      packet << conf.gridWidth << conf.gridHeight;
+      packet << rosterVersion << static_cast<sf::Uint8>(includeRoster ? 1 : 0);
+      if (includeRoster) {
+        packet << static_cast<sf::Uint32>(players->size());
+        for (const auto &[id, player] : *players) {
+          packet << id << player.name << player.color.r << player.color.g
+                 << player.color.b;
+        }
+      }
+      packet << frame << static_cast<sf::Uint32>(players->size());
+      for (const auto &[id, player] : *players) {
+        packet << id << player.position.x << player.position.y;
+      }
+    };
+    keyframePacket.clear();
+    keyframePacketRle.clear();
+    if (keyframeFrame || !clientsNeedingKeyframe.empty()) {
+      bool anyRaw = false, anyRle = spectatorsActive;
+      for (const auto &[id, features] : clientFeatures) {
+        if (features & cycles::protocol::WindowedSnapshots) {
+          continue; // windowed clients never receive full-grid keyframes
+        }
+        (features & cycles::protocol::CompressedGrids ? anyRle : anyRaw) = true;
+      }
+      if (anyRaw || clientFeatures.empty()) {
+        keyframePacket << static_cast<sf::Uint8>(
+            cycles::protocol::SnapshotKind::Keyframe);
+        writeBody(keyframePacket, true);
+        keyframePacket << static_cast<sf::Uint8>(
+            cycles::protocol::GridEncoding::Raw);
+        // The grid is contiguous, append it as a single block instead of
+        // going through operator<< once per cell
+        keyframePacket.append(grid.data(), grid.size() * sizeof(sf::Uint8));
+      }
+      if (anyRle) {
+        keyframePacketRle << static_cast<sf::Uint8>(
+            cycles::protocol::SnapshotKind::Keyframe);
+        writeBody(keyframePacketRle, true);
+        keyframePacketRle << static_cast<sf::Uint8>(
+            cycles::protocol::GridEncoding::Rle);
+        cycles::protocol::appendRleGrid(keyframePacketRle, grid.data(),
+                                        grid.size());
+      }
+    }
+    deltaPacket.clear();
+    udpDeltaPacket.clear();
+    if (!keyframeFrame) {
+      deltaPacket << static_cast<sf::Uint8>(
+          cycles::protocol::SnapshotKind::Delta);
+      writeBody(deltaPacket, rosterVersion != lastSentRosterVersion);
+      deltaPacket << static_cast<sf::Uint32>(dirty.size());
+      for (auto index : dirty) {
+        deltaPacket << index << grid[index];
+      }
+      bool anyUdp = spectatorsActive;
+      for (const auto &[id, features] : clientFeatures) {
+        anyUdp |= (features & cycles::protocol::UdpSnapshots) != 0;
+      }
+      if (anyUdp) {
+        // Cumulative deltas must stand alone on a lossy channel, so they
+        // always carry the roster and every cell touched since the keyframe
+        std::sort(dirtySinceKeyframe.begin(), dirtySinceKeyframe.end());
+        dirtySinceKeyframe.erase(
+            std::unique(dirtySinceKeyframe.begin(), dirtySinceKeyframe.end()),
+            dirtySinceKeyframe.end());
+        // Base keyframe and frame lead the packet so a client can decide to
+        // drop a stale datagram before parsing the rest
+        udpDeltaPacket << static_cast<sf::Uint8>(
+                              cycles::protocol::SnapshotKind::CumulativeDelta)
+                       << static_cast<sf::Uint32>(lastKeyframeBuiltFrame)
+                       << static_cast<sf::Int32>(frame);
+        writeBody(udpDeltaPacket, true);
+        udpDeltaPacket << static_cast<sf::Uint32>(dirtySinceKeyframe.size());
+        for (auto index : dirtySinceKeyframe) {
+          udpDeltaPacket << index << grid[index];
+        }
+      }
+    }
+    windowBasePacket.clear();
+    bool anyWindow = false;
+    for (const auto &[id, features] : clientFeatures) {
+      anyWindow |= (features & cycles::protocol::WindowedSnapshots) != 0;
+    }
+    if (anyWindow) {
+      // Every Window packet is self-contained, so there is no keyframe/delta
+      // split; the roster still travels only when a client lacks it
+      windowBasePacket << static_cast<sf::Uint8>(
+          cycles::protocol::SnapshotKind::Window);
+      writeBody(windowBasePacket,
+                keyframeFrame || rosterVersion != lastSentRosterVersion ||
+                    !clientsNeedingKeyframe.empty());
+    }
+    if (spectatorsActive) {
+      // One copy into the triple buffer per tick, however many viewers;
+      // the broadcast thread takes it from here
+      auto &slot = spectatorFeed.writeSlot();
+      slot.packet = keyframeFrame ? keyframePacketRle : udpDeltaPacket;
+      slot.frame = frame;
+      spectatorFeed.publish();
+    }
+    lastSentRosterVersion = rosterVersion;
+  }
+
+  // Append the window around one client's head: its offset and dimensions,
+  // then the raw cells row by row
+  void appendWindow(sf::Packet &packet, sf::Vector2i center) {
     const auto &grid = game->getGrid();
-    auto players = game->getPlayers();
-    packet << static_cast<sf::Uint32>(players.size());
-    for (const auto &[id, player] : players) {
-      packet << player.position.x << player.position.y << player.color.r
-             << player.color.g << player.color.b << player.name << id << frame;
-    }
-    for (auto &cell : grid) {
-      packet << cell;
-    }
-    std::vector<Id> successful;
-    for (const auto &[id, clientSocket] : clientSockets) {
-      if (clientSocket->send(packet) != sf::Socket::Done) {
-        spdlog::debug("Server ({}): Failed to send game state to player {}",
-                      frame, id);
+    const int radius = conf.interestRadius;
+    const int x0 = std::max(0, center.x - radius);
+    const int y0 = std::max(0, center.y - radius);
+    const int x1 = std::min(conf.gridWidth, center.x + radius + 1);
+    const int y1 = std::min(conf.gridHeight, center.y + radius + 1);
+    packet << x0 << y0 << (x1 - x0) << (y1 - y0);
+    for (int y = y0; y < y1; y++) {
+      packet.append(grid.data() + y * conf.gridWidth + x0,
+                    (x1 - x0) * sizeof(sf::Uint8));
+    }
+  }
+
+  // Exchange one snapshot send and one direction receive with every client.
+  // Receives block on a SocketSelector until a socket is actually readable,
+  // so we no longer re-poll every socket for up to the whole communication
+  // budget. SFML's selector cannot signal writability, so pending sends are
+  // retried with a short backoff instead.
+  void communicateWithClients(std::map<Id, Direction> &newDirs,
+                              std::set<Id> &timedOutPlayers,
+                              sf::Clock &clock) {
+    auto players = game->getPlayerSnapshot();
+    for (auto &client : clientIO) {
+      client.phase = ClientIO::Phase::SendPending;
+      const bool wantsKeyframe =
+          keyframeFrame || clientsNeedingKeyframe.count(client.id) > 0;
+      const bool udp = client.features & cycles::protocol::UdpSnapshots;
+      const bool rle = client.features & cycles::protocol::CompressedGrids;
+      client.windowed =
+          (client.features & cycles::protocol::WindowedSnapshots) != 0;
+      client.udpSend = !wantsKeyframe && udp;
+      client.sendSource = wantsKeyframe
+                              ? (rle ? &keyframePacketRle : &keyframePacket)
+                              : &deltaPacket;
+      if (client.windowed) {
+        client.sendSource = &windowBasePacket;
+        const auto it = players->find(client.id);
+        client.windowCenter =
+            it != players->end() ? it->second.position : sf::Vector2i{0, 0};
+      }
+      client.prepared = false;
+      client.sendStatus = sf::Socket::NotReady;
+    }
+    clock.restart();
+    while (true) {
+      // Datagrams are fire-and-forget, but a cumulative delta is idempotent
+      // against the last keyframe, so while a client's reply is still
+      // pending the same frame is retransmitted on a short interval: a
+      // single dropped datagram costs latency, not a spurious timeout kill
+      const sf::Int32 elapsedMs = clock.getElapsedTime().asMilliseconds();
+      for (auto &client : clientIO) {
+        if (!client.udpSend) {
+          continue;
+        }
+        if (client.phase == ClientIO::Phase::SendPending) {
+          udpSocket.send(udpDeltaPacket, client.socket->getRemoteAddress(),
+                         client.udpPort);
+          client.lastUdpSendMs = elapsedMs;
+          client.phase = ClientIO::Phase::ReceivePending;
+        } else if (client.phase == ClientIO::Phase::ReceivePending &&
+                   elapsedMs - client.lastUdpSendMs >= udp_resend_interval) {
+          udpSocket.send(udpDeltaPacket, client.socket->getRemoteAddress(),
+                         client.udpPort);
+          client.lastUdpSendMs = elapsedMs;
+        }
+      }
+      // Fan the TCP sends out across the pool so one client with a full
+      // kernel buffer cannot make every later client's snapshot late; the
+      // per-client copy and the send syscalls all run in parallel
+      sendTasks.clear();
+      for (auto &client : clientIO) {
+        if (client.phase != ClientIO::Phase::SendPending) {
+          continue;
+        }
+        sendTasks.push_back([this, &client] {
+          if (!client.prepared) {
+            client.sendPacket = *client.sendSource;
+            if (client.windowed) {
+              // The grid is read-only for the rest of the tick, so the
+              // per-client window can be cut on the pool thread
+              appendWindow(client.sendPacket, client.windowCenter);
+            }
+            client.prepared = true;
+          }
+          client.sendStatus = client.socket->send(client.sendPacket);
+        });
+      }
+      sendPool.run(sendTasks);
+      size_t sendsPending = 0;
+      for (auto &client : clientIO) {
+        if (client.phase != ClientIO::Phase::SendPending) {
+          continue;
+        }
+        if (client.sendStatus == sf::Socket::Done) {
+          // UDP clients stay pinned to TCP keyframes until the periodic one
+          // that cumulative deltas are based on
+          const bool udp = client.features & cycles::protocol::UdpSnapshots;
+          if (!udp || keyframeFrame) {
+            clientsNeedingKeyframe.erase(client.id);
+          }
+          client.phase = ClientIO::Phase::ReceivePending;
+          spdlog::debug("Server ({}): Game state sent to player {}", frame,
+                        client.id);
+        } else {
+          sendsPending++;
+        }
+      }
+      size_t receivesPending = 0;
+      size_t udpAwaitingReply = 0;
+      receiveSelector.clear();
+      for (auto &client : clientIO) {
+        if (client.phase == ClientIO::Phase::ReceivePending) {
+          receiveSelector.add(*client.socket);
+          receivesPending++;
+          if (client.udpSend) {
+            udpAwaitingReply++;
+          }
+        }
+      }
+      if (sendsPending == 0 && receivesPending == 0) {
+        break;
+      }
+      const auto remaining = max_client_communication_time -
+                             clock.getElapsedTime().asMilliseconds();
+      if (remaining <= 0) {
+        for (auto &client : clientIO) {
+          if (client.phase != ClientIO::Phase::Done) {
+            timedOutPlayers.insert(client.id);
+          }
+        }
+        break;
+      }
+      if (receivesPending > 0) {
+        // Shorten the wait while sends are still outstanding so they get
+        // retried promptly, and cap it while datagram replies are pending
+        // so their retransmits fire on schedule
+        sf::Int32 waitBudget = remaining;
+        if (sendsPending > 0) {
+          waitBudget = std::min<sf::Int32>(waitBudget, 1);
+        } else if (udpAwaitingReply > 0) {
+          waitBudget = std::min<sf::Int32>(waitBudget, udp_resend_interval);
+        }
+        if (!receiveSelector.wait(sf::milliseconds(waitBudget))) {
+          continue;
+        }
+        for (auto &client : clientIO) {
+          if (client.phase != ClientIO::Phase::ReceivePending ||
+              !receiveSelector.isReady(*client.socket)) {
+            continue;
+          }
+          sf::Packet packet;
+          if (client.socket->receive(packet) == sf::Socket::Done) {
+            int direction;
+            packet >> direction;
+            spdlog::debug("Received direction {} from player {}", direction,
+                          client.id);
+            newDirs[client.id] = static_cast<Direction>(direction);
+            client.phase = ClientIO::Phase::Done;
+          }
+        }
       } else {
-        successful.push_back(id);
-        spdlog::debug("Server ({}): Game state sent to player {}", frame, id);
+        sf::sleep(sf::milliseconds(1));
+      }
+    }
+  }
+
+  // Sleep until just before the next tick deadline, then spin the last
+  // stretch for accuracy. Deadlines advance by a fixed period from the
+  // previous one, so the tick rate does not drift; if a tick overran badly
+  // the schedule is re-anchored instead of bursting to catch up.
+  void waitForNextTick(std::chrono::steady_clock::time_point &nextTick,
+                       std::chrono::steady_clock::duration period) {
+    const auto spinWindow = std::chrono::milliseconds(2);
+    if (std::chrono::steady_clock::now() < nextTick - spinWindow) {
+      std::this_thread::sleep_until(nextTick - spinWindow);
+    }
+    while (std::chrono::steady_clock::now() < nextTick) {
+      std::this_thread::yield();
+    }
+    nextTick += period;
+    if (std::chrono::steady_clock::now() > nextTick + period) {
+      nextTick = std::chrono::steady_clock::now() + period;
+    }
+  }
+
+  // Runs on the accept thread. Replies with a neutral color (spectators
+  // spawn no player) and hands the socket to the broadcast thread.
+  void admitSpectator(std::shared_ptr<sf::TcpSocket> socket) {
+    if (spectatorCount.load() >= static_cast<size_t>(conf.maxSpectators)) {
+      spdlog::info("Spectator cap ({}) reached, turning a viewer away",
+                   conf.maxSpectators);
+      socket->disconnect();
+      return;
+    }
+    // The feed is shared by every viewer, so the accepted features are
+    // fixed: RLE keyframes plus cumulative deltas
+    sf::Packet colorPacket;
+    colorPacket << sf::Uint8(0) << sf::Uint8(0) << sf::Uint8(0)
+                << static_cast<sf::Uint8>(cycles::protocol::Spectator |
+                                          cycles::protocol::CompressedGrids);
+    if (socket->send(colorPacket) != sf::Socket::Done) {
+      return;
+    }
+    socket->setBlocking(false);
+    spectatorCount.fetch_add(1);
+    while (!spectatorMailbox.push(socket)) {
+      sf::sleep(sf::milliseconds(1));
+    }
+    spdlog::info("Spectator connected ({} viewing)", spectatorCount.load());
+  }
+
+  // The broadcast thread: fans the one packet the tick serialized out to
+  // every viewer. Each viewer resends from its own copy of the shared bytes
+  // (sf::Packet keeps partial-send progress inside the packet), so a slow
+  // viewer only delays itself: it skips feed frames while still sending,
+  // which cumulative deltas make safe.
+  void spectatorLoop() {
+    std::vector<std::pair<std::shared_ptr<sf::TcpSocket>, sf::Packet>>
+        spectators;
+    std::vector<bool> sending;
+    int lastFeedFrame = -1;
+    while (broadcasting.load()) {
+      std::shared_ptr<sf::TcpSocket> joined;
+      while (spectatorMailbox.pop(joined)) {
+        spectators.emplace_back(std::move(joined), sf::Packet());
+        sending.push_back(false);
+      }
+      const auto &feed = spectatorFeed.read();
+      const bool fresh = feed.frame != lastFeedFrame;
+      if (fresh) {
+        lastFeedFrame = feed.frame;
+      }
+      bool busy = false;
+      for (size_t i = 0; i < spectators.size(); i++) {
+        auto &[socket, packet] = spectators[i];
+        if (fresh && !sending[i]) {
+          packet = feed.packet;
+          sending[i] = true;
+        }
+        if (!sending[i]) {
+          continue;
+        }
+        const auto status = socket->send(packet);
+        if (status == sf::Socket::Done) {
+          sending[i] = false;
+        } else if (status == sf::Socket::Disconnected ||
+                   status == sf::Socket::Error) {
+          socket.reset();
+        } else {
+          busy = true; // Partial or NotReady: retried on the next pass
+        }
+      }
+      for (size_t i = spectators.size(); i-- > 0;) {
+        if (spectators[i].first == nullptr) {
+          spectators.erase(spectators.begin() + i);
+          sending.erase(sending.begin() + i);
+          spectatorCount.fetch_sub(1);
+          spdlog::info("Spectator disconnected ({} viewing)",
+                       spectatorCount.load());
+        }
+      }
+      if (!fresh && !busy) {
+        sf::sleep(sf::milliseconds(2));
       }
     }
-    return successful;
   }
 
   void gameLoop() {
-    sf::Clock clock;
     sf::Clock clientCommunicationClock;
+    const auto period = std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / conf.tickRate));
+    auto nextTick = std::chrono::steady_clock::now() + period;
     while (running && !game->isGameOver()) {
-      if (clock.getElapsedTime().asMilliseconds() >= 33) { // ~30 fps
-        clock.restart();
-        std::scoped_lock lock(serverMutex);
+      if (!conf.uncappedTickRate) {
+        waitForNextTick(nextTick, period);
+      }
+      {
+        StageTimer wholeTick(*tickStats, TickStats::WholeTick);
+        // Joins parsed by the accept thread enter the match only here, at
+        // the tick boundary; the rest of the tick owns its state outright
+        // and never takes a lock
+        processJoins();
         game->setFrame(frame);
-        checkPlayers();
-        auto clientsUnsent = clientSockets;
-        decltype(clientSockets) toRecieve;
+        {
+          StageTimer timer(*tickStats, TickStats::CheckPlayers);
+          checkPlayers();
+        }
+        {
+          StageTimer timer(*tickStats, TickStats::BuildPackets);
+          buildGameStatePackets();
+        }
+        syncClientIO();
         std::map<Id, Direction> newDirs;
         std::set<Id> timedOutPlayers;
-        clientCommunicationClock.restart();
-        while (clientsUnsent.size() > 0 || toRecieve.size() > 0) {
-          auto successful = sendGameState(clientsUnsent);
-          for (auto s : successful) {
-            clientsUnsent.erase(s);
-            toRecieve[s] = clientSockets[s];
-          }
-          auto succesfulrec = receiveClientInput(toRecieve);
-          for (auto s : succesfulrec) {
-            toRecieve.erase(s.first);
-            newDirs[s.first] = s.second;
-          }
-          spdlog::debug("Server ({}): Clients unsent: {}", frame,
-                        clientsUnsent.size());
-          spdlog::debug("Server ({}): Clients to recieve: {}", frame,
-                        toRecieve.size());
-          // Check for clients that have not sent input for a long time
-          if (clientCommunicationClock.getElapsedTime().asMilliseconds() >
-              max_client_communication_time) {
-            // Mark all remaining clients for removal
-            for (auto [id, socket] : clientsUnsent) {
-              timedOutPlayers.insert(id);
-            }
-            for (auto [id, socket] : toRecieve) {
-              timedOutPlayers.insert(id);
-            }
-            break;
-          }
+        {
+          StageTimer timer(*tickStats, TickStats::Communicate);
+          communicateWithClients(newDirs, timedOutPlayers,
+                                 clientCommunicationClock);
         }
         for (auto id : timedOutPlayers) {
           spdlog::info(
               "Server ({}): Client {} has not sent input for a long time",
               frame, id);
+          if (replayRecorder.isOpen()) {
+            replayRecorder.recordLeave(id);
+          }
           game->removePlayer(id);
           clientSockets.erase(id);
+          clientFeatures.erase(id);
+          clientUdpPorts.erase(id);
+          clientsNeedingKeyframe.erase(id);
+          clientCount.store(clientSockets.size());
+          clientSetDirty = true;
           newDirs.erase(id);
         }
-        game->movePlayers(newDirs);
+        if (replayRecorder.isOpen()) {
+          replayRecorder.recordTick(frame, newDirs);
+        }
+        {
+          StageTimer timer(*tickStats, TickStats::MovePlayers);
+          game->movePlayers(newDirs);
+        }
+        if (conf.seed != 0 && frame % conf.statsInterval == 0) {
+          // Seeded runs log a periodic digest; comparing the logs of two
+          // runs verifies they played bit-identical matches
+          spdlog::info("Server ({}): state hash {:016x}", frame,
+                       game->stateHash());
+        }
+        if (statsCsvStream.is_open() && frame > 0 &&
+            frame % conf.statsInterval == 0) {
+          tickStats->writeCsvRow(statsCsvStream, frame, clientSockets.size());
+        }
         frame++;
       }
     }
   }
 };
 
+// Hosts several independent matches in one process. One listener routes
+// incoming clients to a match by the token they send at the handshake (or
+// round-robin when they send none), and a worker pool runs the match tick
+// loops so an N-core box plays N matches at once instead of one per
+// process launch.
+class Tournament {
+  const Configuration conf;
+  sf::TcpListener listener;
+  std::vector<std::shared_ptr<Game>> games;
+  std::vector<std::unique_ptr<GameServer>> matches;
+
+public:
+  Tournament(Configuration conf) : conf(conf) {
+    const char *portenv = std::getenv("CYCLES_PORT");
+    if (portenv == nullptr) {
+      spdlog::critical("Please set the CYCLES_PORT environment variable");
+      exit(1);
+    }
+    listener.listen(std::stoi(portenv));
+    listener.setBlocking(false);
+    if (listener.getLocalPort() == 0) {
+      spdlog::critical("Failed to bind to port {}", portenv);
+      exit(1);
+    }
+    spdlog::info("Tournament: hosting {} matches on port {}", conf.matches,
+                 portenv);
+    for (int i = 0; i < conf.matches; i++) {
+      // Per-match output files get the match index as a suffix so the
+      // matches do not clobber each other
+      Configuration matchConf = conf;
+      if (!matchConf.replayFile.empty()) {
+        matchConf.replayFile += "-match" + std::to_string(i);
+      }
+      if (!matchConf.statsCsv.empty()) {
+        matchConf.statsCsv += "-match" + std::to_string(i);
+      }
+      games.push_back(std::make_shared<Game>(matchConf));
+      matches.push_back(
+          std::make_unique<GameServer>(games.back(), matchConf, false));
+    }
+  }
+
+  void run() {
+    acceptClients();
+    runMatches();
+    reportResults();
+  }
+
+private:
+  // Lobby phase: route each handshake to its match until every match is
+  // full or the lobby times out
+  void acceptClients() {
+    spdlog::info("Tournament: lobby open for {} s", conf.startTimeout);
+    sf::Clock lobbyClock;
+    size_t nextMatch = 0;
+    size_t clients = 0;
+    const size_t capacity =
+        static_cast<size_t>(conf.matches) * conf.maxClients;
+    while (clients < capacity &&
+           lobbyClock.getElapsedTime().asSeconds() < conf.startTimeout) {
+      auto clientSocket = std::make_shared<sf::TcpSocket>();
+      if (listener.accept(*clientSocket) != sf::Socket::Done) {
+        sf::sleep(sf::milliseconds(10));
+        continue;
+      }
+      clientSocket->setBlocking(true);
+      sf::Packet namePacket;
+      if (clientSocket->receive(namePacket) != sf::Socket::Done) {
+        continue;
+      }
+      std::string playerName;
+      namePacket >> playerName;
+      sf::Uint8 requestedFeatures = 0;
+      std::string matchToken;
+      unsigned short udpPort = 0;
+      if (!namePacket.endOfPacket()) {
+        namePacket >> requestedFeatures;
+      }
+      if (!namePacket.endOfPacket()) {
+        namePacket >> matchToken;
+      }
+      if (!namePacket.endOfPacket()) {
+        namePacket >> udpPort;
+      }
+      // Tournament matches have no broadcast tier; turn viewers away
+      // rather than spawning a player for them
+      if (requestedFeatures & cycles::protocol::Spectator) {
+        clientSocket->disconnect();
+        continue;
+      }
+      // A numeric token pins the client to a match; tokenless clients are
+      // spread round-robin
+      size_t match;
+      if (!matchToken.empty()) {
+        try {
+          match = std::stoul(matchToken) % matches.size();
+        } catch (const std::exception &) {
+          spdlog::warn("Tournament: ignoring bad match token '{}' from {}",
+                       matchToken, playerName);
+          match = nextMatch++ % matches.size();
+        }
+      } else {
+        match = nextMatch++ % matches.size();
+      }
+      spdlog::info("Tournament: routing {} to match {}", playerName, match);
+      matches[match]->registerClient(clientSocket, playerName,
+                                     requestedFeatures, udpPort);
+      clients++;
+    }
+  }
+
+  void runMatches() {
+    // Fixed worker pool pulling match indices off a shared counter; with
+    // enough cores every match ticks concurrently, otherwise matches queue
+    size_t workerCount =
+        conf.workers > 0 ? conf.workers : std::thread::hardware_concurrency();
+    workerCount = std::min(std::max<size_t>(workerCount, 1), matches.size());
+    spdlog::info("Tournament: running {} matches on {} workers",
+                 matches.size(), workerCount);
+    std::atomic<size_t> nextMatch{0};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; i++) {
+      workers.emplace_back([this, &nextMatch] {
+        while (true) {
+          const size_t match = nextMatch.fetch_add(1);
+          if (match >= matches.size()) {
+            break;
+          }
+          if (matches[match]->getClientCount() == 0) {
+            spdlog::info("Tournament: match {} has no clients, skipping",
+                         match);
+            continue;
+          }
+          matches[match]->run();
+          spdlog::info("Tournament: match {} finished", match);
+        }
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  void reportResults() {
+    for (size_t i = 0; i < matches.size(); i++) {
+      auto players = games[i]->getPlayerSnapshot();
+      if (players->size() == 1) {
+        spdlog::info("Tournament: match {} winner: {} (frame {})", i,
+                     players->begin()->second.name, games[i]->getFrame());
+      } else {
+        spdlog::info("Tournament: match {} ended with no winner", i);
+      }
+    }
+  }
+};
+
 int main(int argc, char *argv[]) {
 #if SPDLOG_ACTIVE_LEVEL == SPDLOG_LEVEL_TRACE
   spdlog::set_level(spdlog::level::debug);
 #endif
-  std::srand(static_cast<unsigned int>(std::time(nullptr)));
-  const std::string config_path = argc > 1 ? argv[1] : "config.yaml";
-  const Configuration conf(config_path);
+  std::string config_path = "config.yaml";
+  bool forceHeadless = false;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--headless") {
+      forceHeadless = true;
+    } else {
+      config_path = arg;
+    }
+  }
+  Configuration conf(config_path);
+  if (forceHeadless) {
+    conf.headless = true;
+  }
+  // Nothing in the game itself uses rand() anymore, but keep the seeding
+  // deterministic too so any stray caller cannot diverge a seeded run
+  std::srand(conf.seed != 0 ? conf.seed
+                            : static_cast<unsigned int>(std::time(nullptr)));
+  if (conf.tournament) {
+    Tournament tournament(conf);
+    tournament.run();
+    return 0;
+  }
   auto game = std::make_shared<Game>(conf);
   GameServer server(game, conf);
-  GameRenderer renderer(conf);
   std::thread acceptThread(&GameServer::acceptClients, &server);
+  if (conf.headless) {
+    // No window: start once enough clients joined or the lobby times out
+    spdlog::info("Running headless, waiting for {} clients (timeout {} s)",
+                 conf.minClients, conf.startTimeout);
+    sf::Clock lobbyClock;
+    while (static_cast<int>(server.getClientCount()) < conf.minClients &&
+           lobbyClock.getElapsedTime().asSeconds() < conf.startTimeout) {
+      server.processJoins();
+      sf::sleep(sf::milliseconds(50));
+    }
+    // The accept thread stays up through the match for late spectators;
+    // only player admission closes here
+    server.setAcceptingClients(false);
+    server.processJoins(); // pick up handshakes still in the mailbox
+    spdlog::info("Starting headless match with {} clients",
+                 server.getClientCount());
+    server.run();
+    server.stopAccepting();
+    acceptThread.join();
+    return 0;
+  }
+  GameRenderer renderer(conf);
+  renderer.setTickStats(server.getTickStats());
   bool acceptingClients = true;
   auto spaceEvent = [&acceptingClients](auto &event) {
     if (event.type == sf::Event::KeyPressed &&
@@ -241,11 +1126,13 @@ int main(int argc, char *argv[]) {
     }
   };
   while (acceptingClients && renderer.isOpen()) {
+    server.processJoins();
     renderer.handleEvents({spaceEvent});
     renderer.renderSplashScreen(game);
   }
+  // Close player admission but keep the accept thread up for spectators
+  // joining mid-match
   server.setAcceptingClients(false);
-  acceptThread.join();
   std::thread serverThread(&GameServer::run, &server);
   while (renderer.isOpen()) {
     renderer.handleEvents();
@@ -253,5 +1140,7 @@ int main(int argc, char *argv[]) {
   }
   server.stop();
   serverThread.join();
+  server.stopAccepting();
+  acceptThread.join();
   return 0;
 }
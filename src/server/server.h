@@ -1,25 +1,99 @@
 #pragma once
 #include "api.h"
 #include <SFML/Main.hpp>
-#include <list>
+#include <cstddef>
+#include <vector>
 
 namespace cycles_server {
 using cycles::Direction;
 using cycles::Id;
 
+/**
+ * @brief Contiguous ring buffer holding a player's tail cells, newest first
+ *
+ * push_front and pop_back are the only mutators the game needs. Storage is
+ * one flat allocation (grown geometrically as tails lengthen), so traversal
+ * is cache-linear and steady-state moves allocate nothing.
+ */
+class TailBuffer {
+  std::vector<sf::Vector2i> cells;
+  size_t head = 0; // index of the newest cell
+  size_t count = 0;
+
+public:
+  TailBuffer() : cells(64) {}
+
+  size_t size() const { return count; }
+
+  bool empty() const { return count == 0; }
+
+  const sf::Vector2i &front() const { return cells[head]; }
+
+  const sf::Vector2i &back() const {
+    return cells[(head + count - 1) % cells.size()];
+  }
+
+  void push_front(sf::Vector2i cell) {
+    if (count == cells.size()) {
+      grow();
+    }
+    head = (head + cells.size() - 1) % cells.size();
+    cells[head] = cell;
+    count++;
+  }
+
+  void pop_back() { count--; }
+
+  // Forward iteration, newest to oldest
+  class const_iterator {
+    const TailBuffer *buffer;
+    size_t offset;
+
+  public:
+    const_iterator(const TailBuffer *buffer, size_t offset)
+        : buffer(buffer), offset(offset) {}
+    const sf::Vector2i &operator*() const {
+      return buffer->cells[(buffer->head + offset) % buffer->cells.size()];
+    }
+    const_iterator &operator++() {
+      offset++;
+      return *this;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return offset != other.offset;
+    }
+  };
+
+  const_iterator begin() const { return {this, 0}; }
+
+  const_iterator end() const { return {this, count}; }
+
+private:
+  void grow() {
+    std::vector<sf::Vector2i> bigger(cells.size() * 2);
+    for (size_t i = 0; i < count; i++) {
+      bigger[i] = cells[(head + i) % cells.size()];
+    }
+    cells = std::move(bigger);
+    head = 0;
+  }
+};
+
 struct Player {
   sf::Vector2i position;
-  std::list<sf::Vector2i> tail;
+  TailBuffer tail;
   sf::Color color;
   std::string name;
-  Id id;
-  Player() : id(std::rand()) {}
+  // Always assigned by Game::addPlayer; a fixed default keeps construction
+  // free of global RNG state so seeded runs are reproducible
+  Id id = 0;
 };
 
 
 struct Configuration {
 
   int maxClients = 60;
+  int maxSpectators = 20; // Read-only viewer connections, capped separately
   int gridWidth = 100;
   int gridHeight = 100;
   int gameWidth = 1000;
@@ -27,6 +101,20 @@ struct Configuration {
   int gameBannerHeight = 100;
   float cellSize = 10;
   bool enablePostProcessing = false;
+  bool headless = false;  // Run without a window, start automatically
+  int minClients = 2;     // Headless: start once this many clients joined
+  int startTimeout = 30;  // Headless: start anyway after this many seconds
+  bool uncappedTickRate = false; // Tick as fast as the clients respond
+  int tickRate = 30;             // Game loop ticks per second
+  std::string statsCsv = "";     // Tick timing CSV export path (empty: off)
+  int statsInterval = 150;       // Frames between CSV stat rows
+  std::string replayFile = "";   // Match replay recording path (empty: off)
+  unsigned int seed = 0; // Deterministic mode: fixed RNG seed (0: entropy)
+  int interestRadius = 0;  // Send each client only the grid within this many
+                           // cells of its head (0: full snapshots)
+  bool tournament = false; // Host several matches in one process (headless)
+  int matches = 4;         // Tournament: number of concurrent matches
+  int workers = 0;         // Tournament: worker threads (0: hardware threads)
   Configuration(std::string configPath);
 };
 } // namespace cycles_server
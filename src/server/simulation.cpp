@@ -0,0 +1,61 @@
+#include "simulation.h"
+
+namespace cycles_server {
+
+LocalConnection Simulation::connect(const std::string &playerName) {
+  const auto id = game.addPlayer(playerName);
+  const auto color = game.getPlayerSnapshot()->at(id).color;
+  return LocalConnection(this, id, color);
+}
+
+void Simulation::step() {
+  game.movePlayers(pendingMoves);
+  pendingMoves.clear();
+  frame++;
+  game.setFrame(frame);
+}
+
+void Simulation::fillGameState(cycles::GameState &state) {
+  state.gridWidth = conf.gridWidth;
+  state.gridHeight = conf.gridHeight;
+  state.windowOffset = {0, 0};
+  state.windowWidth = conf.gridWidth;
+  state.windowHeight = conf.gridHeight;
+  // The Game's buffers are copied rather than aliased so the state stays
+  // valid across steps, like a deserialized snapshot would
+  const auto &grid = game.getGrid();
+  state.grid.assign(grid.begin(), grid.end());
+  const auto &occupancy = game.getOccupancy();
+  state.occupancy.assign(occupancy.begin(), occupancy.end());
+  const auto players = game.getPlayerSnapshot();
+  state.players.clear();
+  for (const auto &[id, player] : *players) {
+    state.players.push_back(
+        {player.name, player.color, player.position, player.id});
+  }
+  state.frameNumber = frame;
+}
+
+cycles::GameState LocalConnection::receiveGameState() {
+  cycles::GameState state;
+  simulation->fillGameState(state);
+  return state;
+}
+
+void LocalConnection::receiveGameState(cycles::GameState &reuse) {
+  simulation->fillGameState(reuse);
+}
+
+void LocalConnection::sendMove(cycles::Direction direction) {
+  if (lastFrameSent == simulation->frame) {
+    return;
+  }
+  lastFrameSent = simulation->frame;
+  simulation->pendingMoves[id] = direction;
+}
+
+bool LocalConnection::isActive() {
+  return simulation->game.getPlayerSnapshot()->count(id) > 0;
+}
+
+} // namespace cycles_server
@@ -0,0 +1,127 @@
+#pragma once
+#include "api.h"
+#include "game_logic.h"
+#include <map>
+#include <string>
+
+namespace cycles_server {
+
+class Simulation;
+
+/**
+ * @brief In-process stand-in for cycles::Connection
+ *
+ * Hands bot code the same GameState and the same sendMove contract as the
+ * network client, but reads the Game directly: no sockets, no serialization
+ * and no tick-rate floor, so a training harness can run millions of moves
+ * per second on one machine.
+ */
+class LocalConnection {
+  Simulation *simulation = nullptr;
+  Id id = 0;
+  sf::Color color;
+  int lastFrameSent = -1;
+
+  friend Simulation;
+  LocalConnection(Simulation *simulation, Id id, sf::Color color)
+      : simulation(simulation), id(id), color(color) {}
+
+public:
+  /**
+   * @brief Get the current game state
+   *
+   * Same contract as Connection::receiveGameState, minus the blocking: the
+   * state reflects the last completed Simulation::step.
+   *
+   * @return cycles::GameState The game state
+   */
+  cycles::GameState receiveGameState();
+
+  /**
+   * @brief Get the current game state into a caller-owned GameState
+   *
+   * Reuses the capacity of the given object's grid and players vectors, so
+   * a harness that keeps one GameState per bot allocates nothing per frame.
+   *
+   * @param reuse The game state to overwrite
+   */
+  void receiveGameState(cycles::GameState &reuse);
+
+  /**
+   * @brief Record the player's move for the next step
+   *
+   * Same once-per-frame rule as Connection::sendMove: a second call in the
+   * same frame is ignored. The move takes effect when the harness calls
+   * Simulation::step.
+   *
+   * @param direction The direction of the move
+   */
+  void sendMove(cycles::Direction direction);
+
+  /// The color assigned to the player, as the connect handshake would return
+  sf::Color getColor() const { return color; }
+
+  cycles::Id getId() const { return id; }
+
+  /**
+   * @brief Check if the player is still alive in the simulation
+   *
+   * @return true if the player is alive
+   * @return false if the player has died
+   */
+  bool isActive();
+};
+
+/**
+ * @brief A whole match run in-process, without server or sockets
+ *
+ * Owns a Game and exposes LocalConnection handles that match the
+ * include/api.h client surface, so the same bot code runs against a live
+ * server or against this. The harness drives the loop explicitly:
+ *
+ *   Simulation sim(conf);
+ *   auto bot = sim.connect("trainee");
+ *   while (!sim.isGameOver()) {
+ *     bot.sendMove(decide(bot.receiveGameState()));
+ *     sim.step();
+ *   }
+ */
+class Simulation {
+  Configuration conf;
+  Game game;
+  std::map<Id, cycles::Direction> pendingMoves;
+  int frame = 0;
+
+  friend LocalConnection;
+
+  void fillGameState(cycles::GameState &state);
+
+public:
+  explicit Simulation(Configuration conf) : conf(conf), game(conf) {}
+
+  /**
+   * @brief Add a player to the match
+   *
+   * The in-process analogue of Connection::connect; spawns the player on a
+   * random free cell exactly like the server would.
+   *
+   * @param playerName The name of the player
+   * @return LocalConnection The handle the bot plays through
+   */
+  LocalConnection connect(const std::string &playerName);
+
+  /**
+   * @brief Advance the match by one frame
+   *
+   * Applies every move recorded since the previous step and resolves
+   * collisions. Unlike the server, silent players are not kicked; they
+   * simply keep their position for the frame.
+   */
+  void step();
+
+  bool isGameOver() { return game.isGameOver(); }
+
+  int getFrame() const { return frame; }
+};
+
+} // namespace cycles_server
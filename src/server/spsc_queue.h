@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace cycles_server {
+
+/**
+ * @brief Wait-free single-producer/single-consumer ring buffer
+ *
+ * The mailbox between the client-acceptance thread and whichever thread is
+ * driving the match (the lobby loop before the game starts, the tick thread
+ * after): the producer pushes, the consumer drains at its own pace, and
+ * neither ever takes a lock or waits on the other.
+ *
+ * head is written only by the consumer and tail only by the producer; each
+ * side reads the other's index with acquire to see the slots it hands over.
+ * One slot is kept empty to tell full from empty, so the queue holds up to
+ * Capacity - 1 items.
+ */
+template <typename T, std::size_t Capacity> class SpscQueue {
+  std::array<T, Capacity> slots;
+  std::atomic<std::size_t> head{0}; ///< Next slot the consumer pops
+  std::atomic<std::size_t> tail{0}; ///< Next slot the producer fills
+
+public:
+  /// Producer side. Returns false when the queue is full, leaving the item
+  /// with the caller.
+  bool push(T item) {
+    const auto at = tail.load(std::memory_order_relaxed);
+    const auto next = (at + 1) % Capacity;
+    if (next == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots[at] = std::move(item);
+    tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer side. Returns false when the queue is empty.
+  bool pop(T &item) {
+    const auto at = head.load(std::memory_order_relaxed);
+    if (at == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = std::move(slots[at]);
+    head.store((at + 1) % Capacity, std::memory_order_release);
+    return true;
+  }
+};
+
+} // namespace cycles_server
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace cycles_server {
+
+/**
+ * @brief Wait-free single-writer single-reader triple buffer
+ *
+ * The writer always has a private back slot to fill and publishes it by
+ * swapping it with the middle slot; the reader picks up the freshest
+ * published slot by swapping it to the front. Neither side ever blocks the
+ * other, so a slow consumer (a GPU-bound render frame) can never delay the
+ * producer (the game tick) — it just skips the frames it missed.
+ *
+ * Slot indices and a freshness flag are packed into one atomic byte:
+ * bits 0-1 front, bits 2-3 middle, bits 4-5 back, bit 6 fresh.
+ */
+template <typename T> class TripleBuffer {
+  T slots[3];
+  std::atomic<std::uint8_t> state{0b00'10'01'00};
+
+public:
+  // Writer side: fill the back slot, then publish it
+  T &writeSlot() { return slots[(state.load(std::memory_order_relaxed) >> 4) & 3]; }
+
+  void publish() {
+    std::uint8_t s = state.load(std::memory_order_relaxed);
+    std::uint8_t next;
+    do {
+      next = static_cast<std::uint8_t>((s & 3) | (((s >> 4) & 3) << 2) |
+                                       (((s >> 2) & 3) << 4) | 0x40);
+    } while (!state.compare_exchange_weak(s, next, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed));
+  }
+
+  // Reader side: returns the most recently published slot; the same slot is
+  // returned again if nothing new arrived since the last call
+  const T &read() {
+    std::uint8_t s = state.load(std::memory_order_relaxed);
+    while (s & 0x40) {
+      const std::uint8_t next = static_cast<std::uint8_t>(
+          ((s >> 2) & 3) | ((s & 3) << 2) | (s & 0x30));
+      if (state.compare_exchange_weak(s, next, std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+        s = next;
+        break;
+      }
+    }
+    return slots[s & 3];
+  }
+};
+
+} // namespace cycles_server
@@ -0,0 +1,55 @@
+#include "spatial.h"
+
+namespace cycles {
+namespace spatial {
+
+void DistanceField::compute(const GameState &state, sf::Vector2i source) {
+  offset = state.windowOffset;
+  width = state.windowWidth;
+  height = state.windowHeight;
+  const std::size_t cells = static_cast<std::size_t>(width) * height;
+  distances.assign(cells, unreachable);
+  // Every cell enters the frontier at most once, so a flat array indexed by
+  // head and tail is a queue that never wraps and never allocates mid-search
+  frontier.resize(cells);
+  std::size_t head = 0;
+  std::size_t tail = 0;
+  const std::uint32_t sourceIndex =
+      (source.y - offset.y) * width + (source.x - offset.x);
+  distances[sourceIndex] = 0;
+  frontier[tail++] = sourceIndex;
+  while (head != tail) {
+    const std::uint32_t index = frontier[head++];
+    const int distance = distances[index] + 1;
+    const int x = index % width;
+    auto visit = [&](std::uint32_t next) {
+      if (distances[next] == unreachable &&
+          !((state.occupancy[next >> 6] >> (next & 63)) & 1)) {
+        distances[next] = distance;
+        frontier[tail++] = next;
+      }
+    };
+    if (x > 0) {
+      visit(index - 1);
+    }
+    if (x + 1 < width) {
+      visit(index + 1);
+    }
+    if (index >= static_cast<std::uint32_t>(width)) {
+      visit(index - width);
+    }
+    if (index + width < cells) {
+      visit(index + width);
+    }
+  }
+  reachable = static_cast<int>(tail);
+}
+
+int territorySize(const GameState &state, sf::Vector2i source) {
+  DistanceField field;
+  field.compute(state, source);
+  return field.reachableCount();
+}
+
+} // namespace spatial
+} // namespace cycles
@@ -155,3 +155,55 @@ TEST(GameLogicTest, Grid){
   auto players = game.getPlayers();
   EXPECT_TRUE(test_grid(grid, players, conf));
 }
+
+TEST(TailBufferTest, PushPopFrontBack) {
+  TailBuffer tail;
+  EXPECT_TRUE(tail.empty());
+  tail.push_front(sf::Vector2i(0, 0));
+  tail.push_front(sf::Vector2i(1, 0));
+  tail.push_front(sf::Vector2i(2, 0));
+  EXPECT_EQ(tail.size(), 3);
+  EXPECT_EQ(tail.front(), sf::Vector2i(2, 0)); // newest
+  EXPECT_EQ(tail.back(), sf::Vector2i(0, 0));  // oldest
+  tail.pop_back();
+  EXPECT_EQ(tail.size(), 2);
+  EXPECT_EQ(tail.back(), sf::Vector2i(1, 0));
+}
+
+TEST(TailBufferTest, IteratesNewestToOldest) {
+  TailBuffer tail;
+  for (int i = 0; i < 5; i++) {
+    tail.push_front(sf::Vector2i(i, 0));
+  }
+  int expected = 4;
+  for (const auto &cell : tail) {
+    EXPECT_EQ(cell, sf::Vector2i(expected, 0));
+    expected--;
+  }
+  EXPECT_EQ(expected, -1);
+}
+
+TEST(TailBufferTest, WrapsAndGrowsPastInitialCapacity) {
+  TailBuffer tail;
+  // Steady-state churn first, so the ring's head has wrapped well before
+  // the buffer has to grow
+  for (int i = 0; i < 200; i++) {
+    tail.push_front(sf::Vector2i(i, i));
+    if (tail.size() > 10) {
+      tail.pop_back();
+    }
+  }
+  // Now grow past the initial capacity without popping
+  for (int i = 200; i < 300; i++) {
+    tail.push_front(sf::Vector2i(i, i));
+  }
+  EXPECT_EQ(tail.size(), 110);
+  EXPECT_EQ(tail.front(), sf::Vector2i(299, 299));
+  EXPECT_EQ(tail.back(), sf::Vector2i(190, 190));
+  int expected = 299;
+  for (const auto &cell : tail) {
+    EXPECT_EQ(cell, sf::Vector2i(expected, expected));
+    expected--;
+  }
+  EXPECT_EQ(expected, 189);
+}
@@ -0,0 +1,241 @@
+// GTest tests for the snapshot wire protocol: packets built the way the
+// server's buildGameStatePackets serializes them, pushed through
+// GameState's decode paths, asserting the reconstructed grid, occupancy
+// bitset and roster cache.
+#include "api.h"
+#include "protocol.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+using namespace cycles;
+
+namespace cycles {
+// Test-only access to GameState's private apply paths, declared a friend
+// in api.h
+struct GameStateTestPeer {
+  static void applyKeyframe(GameState &state, sf::Packet &packet) {
+    state.applyKeyframe(packet);
+  }
+  static void applyDelta(GameState &state, sf::Packet &packet) {
+    state.applyDelta(packet);
+  }
+  static bool applyCumulativeDelta(GameState &state, sf::Packet &packet) {
+    return state.applyCumulativeDelta(packet);
+  }
+  static void applyWindow(GameState &state, sf::Packet &packet) {
+    state.applyWindow(packet);
+  }
+};
+} // namespace cycles
+
+namespace {
+
+constexpr int gridWidth = 8;
+constexpr int gridHeight = 5;
+
+struct TestPlayer {
+  Id id;
+  std::string name;
+  sf::Color color;
+  sf::Vector2i position;
+};
+
+std::vector<TestPlayer> makePlayers() {
+  return {{1, "alice", sf::Color(200, 10, 10), {1, 1}},
+          {2, "bob", sf::Color(10, 200, 10), {6, 3}}};
+}
+
+// Mirror of the server's writeBody lambda in buildGameStatePackets
+void writeBody(sf::Packet &packet, const std::vector<TestPlayer> &players,
+               sf::Uint32 rosterVersion, bool includeRoster, int frame) {
+  packet << gridWidth << gridHeight;
+  packet << rosterVersion << static_cast<sf::Uint8>(includeRoster ? 1 : 0);
+  if (includeRoster) {
+    packet << static_cast<sf::Uint32>(players.size());
+    for (const auto &player : players) {
+      packet << player.id << player.name << player.color.r << player.color.g
+             << player.color.b;
+    }
+  }
+  packet << frame << static_cast<sf::Uint32>(players.size());
+  for (const auto &player : players) {
+    packet << player.id << player.position.x << player.position.y;
+  }
+}
+
+std::vector<Id> makeGrid(const std::vector<TestPlayer> &players) {
+  std::vector<Id> grid(gridWidth * gridHeight, 0);
+  for (const auto &player : players) {
+    grid[player.position.y * gridWidth + player.position.x] = player.id;
+  }
+  return grid;
+}
+
+void expectOccupancyMatchesGrid(const GameState &state) {
+  for (size_t i = 0; i < state.grid.size(); i++) {
+    const bool occupied = (state.occupancy[i >> 6] >> (i & 63)) & 1;
+    EXPECT_EQ(state.grid[i] != 0, occupied);
+  }
+}
+
+GameState keyframedState(const std::vector<TestPlayer> &players, int frame) {
+  const auto grid = makeGrid(players);
+  sf::Packet packet;
+  writeBody(packet, players, 1, true, frame);
+  packet << static_cast<sf::Uint8>(protocol::GridEncoding::Raw);
+  packet.append(grid.data(), grid.size());
+  GameState state;
+  GameStateTestPeer::applyKeyframe(state, packet);
+  return state;
+}
+
+TEST(Protocol, RawKeyframeRoundTrip) {
+  const auto players = makePlayers();
+  const auto state = keyframedState(players, 10);
+  EXPECT_EQ(gridWidth, state.gridWidth);
+  EXPECT_EQ(gridHeight, state.gridHeight);
+  EXPECT_EQ(10, state.frameNumber);
+  EXPECT_EQ(makeGrid(players), state.grid);
+  expectOccupancyMatchesGrid(state);
+  ASSERT_EQ(players.size(), state.players.size());
+  for (size_t i = 0; i < players.size(); i++) {
+    EXPECT_EQ(players[i].id, state.players[i].id);
+    EXPECT_EQ(players[i].name, state.players[i].name);
+    EXPECT_EQ(players[i].color, state.players[i].color);
+    EXPECT_EQ(players[i].position, state.players[i].position);
+  }
+  // With a full snapshot the window is the whole grid
+  EXPECT_EQ(sf::Vector2i(0, 0), state.windowOffset);
+  EXPECT_EQ(gridWidth, state.windowWidth);
+  EXPECT_EQ(gridHeight, state.windowHeight);
+  EXPECT_EQ(1, state.getGridCell({1, 1}));
+  EXPECT_FALSE(state.isCellEmpty({6, 3}));
+  EXPECT_TRUE(state.isCellEmpty({0, 0}));
+}
+
+TEST(Protocol, RleKeyframeMatchesRaw) {
+  const auto players = makePlayers();
+  const auto grid = makeGrid(players);
+  sf::Packet packet;
+  writeBody(packet, players, 1, true, 10);
+  packet << static_cast<sf::Uint8>(protocol::GridEncoding::Rle);
+  protocol::appendRleGrid(packet, grid.data(), grid.size());
+  GameState state;
+  GameStateTestPeer::applyKeyframe(state, packet);
+  EXPECT_EQ(grid, state.grid);
+  expectOccupancyMatchesGrid(state);
+}
+
+TEST(Protocol, RleCodecRoundTrip) {
+  const std::vector<sf::Uint8> cells = {0, 0, 0, 7, 7, 1, 0, 0, 9};
+  sf::Packet packet;
+  protocol::appendRleGrid(packet, cells.data(), cells.size());
+  std::vector<sf::Uint8> decoded(cells.size(), 255);
+  ASSERT_TRUE(protocol::readRleGrid(packet, decoded.data(), decoded.size()));
+  EXPECT_EQ(cells, decoded);
+}
+
+TEST(Protocol, RleCodecRejectsWrongLength) {
+  const std::vector<sf::Uint8> cells = {0, 0, 3, 3};
+  sf::Packet packet;
+  protocol::appendRleGrid(packet, cells.data(), cells.size());
+  std::vector<sf::Uint8> tooSmall(cells.size() - 1);
+  EXPECT_FALSE(
+      protocol::readRleGrid(packet, tooSmall.data(), tooSmall.size()));
+  sf::Packet truncated;
+  truncated << static_cast<sf::Uint32>(2); // two runs promised, none sent
+  std::vector<sf::Uint8> decoded(cells.size());
+  EXPECT_FALSE(protocol::readRleGrid(truncated, decoded.data(),
+                                     decoded.size()));
+}
+
+TEST(Protocol, DeltaPatchesGridThroughCachedRoster) {
+  auto players = makePlayers();
+  auto state = keyframedState(players, 10);
+  // alice steps right: her old cell empties, the new one takes her id
+  const sf::Uint32 oldIndex = 1 * gridWidth + 1;
+  const sf::Uint32 newIndex = 1 * gridWidth + 2;
+  players[0].position = {2, 1};
+  sf::Packet packet;
+  writeBody(packet, players, 1, false, 11); // same roster, no metadata block
+  packet << static_cast<sf::Uint32>(2);
+  packet << oldIndex << Id(0) << newIndex << Id(1);
+  GameStateTestPeer::applyDelta(state, packet);
+  EXPECT_EQ(11, state.frameNumber);
+  EXPECT_EQ(0, state.getGridCell({1, 1}));
+  EXPECT_EQ(1, state.getGridCell({2, 1}));
+  expectOccupancyMatchesGrid(state);
+  // Metadata resolved from the cached roster even though none travelled
+  ASSERT_EQ(2u, state.players.size());
+  EXPECT_EQ("alice", state.players[0].name);
+  EXPECT_EQ(sf::Vector2i(2, 1), state.players[0].position);
+}
+
+TEST(Protocol, DeltaCarriesRosterWhenPlayersChange) {
+  auto players = makePlayers();
+  auto state = keyframedState(players, 10);
+  players.pop_back(); // bob died
+  sf::Packet packet;
+  writeBody(packet, players, 2, true, 11); // bumped version, fresh roster
+  packet << static_cast<sf::Uint32>(1);
+  packet << static_cast<sf::Uint32>(3 * gridWidth + 6) << Id(0);
+  GameStateTestPeer::applyDelta(state, packet);
+  ASSERT_EQ(1u, state.players.size());
+  EXPECT_EQ("alice", state.players[0].name);
+  EXPECT_TRUE(state.isCellEmpty({6, 3}));
+}
+
+TEST(Protocol, CumulativeDeltaDropsStaleAndMismatched) {
+  auto players = makePlayers();
+  auto state = keyframedState(players, 10); // keyframe at frame 10
+  players[0].position = {2, 1};
+  auto buildCumulative = [&](sf::Uint32 baseFrame, int frame) {
+    sf::Packet packet;
+    packet << baseFrame << static_cast<sf::Int32>(frame);
+    writeBody(packet, players, 1, true, frame);
+    packet << static_cast<sf::Uint32>(2);
+    packet << static_cast<sf::Uint32>(1 * gridWidth + 1) << Id(0)
+           << static_cast<sf::Uint32>(1 * gridWidth + 2) << Id(1);
+    return packet;
+  };
+  // Wrong base keyframe: dropped without touching the state
+  auto wrongBase = buildCumulative(0, 12);
+  EXPECT_FALSE(GameStateTestPeer::applyCumulativeDelta(state, wrongBase));
+  EXPECT_EQ(1, state.getGridCell({1, 1}));
+  // Older than what we already have: dropped
+  auto stale = buildCumulative(10, 10);
+  EXPECT_FALSE(GameStateTestPeer::applyCumulativeDelta(state, stale));
+  // Matching base, newer frame: applied
+  auto good = buildCumulative(10, 12);
+  EXPECT_TRUE(GameStateTestPeer::applyCumulativeDelta(state, good));
+  EXPECT_EQ(12, state.frameNumber);
+  EXPECT_EQ(0, state.getGridCell({1, 1}));
+  EXPECT_EQ(1, state.getGridCell({2, 1}));
+  expectOccupancyMatchesGrid(state);
+}
+
+TEST(Protocol, WindowIndexesRelativeToOffset) {
+  const auto players = makePlayers();
+  // A 3x2 window around bob's head at (6, 3)
+  const int x0 = 5, y0 = 2, width = 3, height = 2;
+  std::vector<Id> window(width * height, 0);
+  window[(3 - y0) * width + (6 - x0)] = 2;
+  sf::Packet packet;
+  writeBody(packet, players, 1, true, 10);
+  packet << x0 << y0 << width << height;
+  packet.append(window.data(), window.size());
+  GameState state;
+  GameStateTestPeer::applyWindow(state, packet);
+  EXPECT_EQ(gridWidth, state.gridWidth);
+  EXPECT_EQ(sf::Vector2i(x0, y0), state.windowOffset);
+  EXPECT_EQ(width, state.windowWidth);
+  EXPECT_EQ(height, state.windowHeight);
+  EXPECT_TRUE(state.isInsideWindow({6, 3}));
+  EXPECT_FALSE(state.isInsideWindow({1, 1}));
+  EXPECT_EQ(2, state.getGridCell({6, 3}));
+  EXPECT_TRUE(state.isCellEmpty({5, 2}));
+  expectOccupancyMatchesGrid(state);
+}
+
+} // namespace
@@ -0,0 +1,84 @@
+// GTest tests for the spatial reasoning helpers: BFS distances, territory
+// counts and window-relative indexing on hand-built game states.
+#include "spatial.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+using namespace cycles;
+
+namespace {
+
+// A game state filled in by hand: the public fields are all the spatial
+// helpers read
+GameState makeState(int width, int height, sf::Vector2i offset = {0, 0}) {
+  GameState state;
+  state.gridWidth = width;
+  state.gridHeight = height;
+  state.windowOffset = offset;
+  state.windowWidth = width;
+  state.windowHeight = height;
+  state.grid.assign(static_cast<size_t>(width) * height, 0);
+  state.occupancy.assign((state.grid.size() + 63) / 64, 0);
+  state.frameNumber = 0;
+  return state;
+}
+
+void occupy(GameState &state, sf::Vector2i position, Id id) {
+  const size_t index = (position.y - state.windowOffset.y) * state.windowWidth +
+                       (position.x - state.windowOffset.x);
+  state.grid[index] = id;
+  state.occupancy[index >> 6] |= std::uint64_t(1) << (index & 63);
+}
+
+TEST(SpatialTest, DistancesOnOpenGrid) {
+  auto state = makeState(5, 5);
+  spatial::DistanceField field;
+  field.compute(state, {2, 2});
+  EXPECT_EQ(0, field.distanceTo({2, 2}));
+  EXPECT_EQ(1, field.distanceTo({2, 1}));
+  EXPECT_EQ(2, field.distanceTo({3, 3}));
+  EXPECT_EQ(4, field.distanceTo({0, 0})); // Manhattan, no diagonals
+  EXPECT_EQ(25, field.reachableCount());
+}
+
+TEST(SpatialTest, WallsBlockAndSplitTerritory) {
+  auto state = makeState(5, 5);
+  // A full vertical wall at x = 2 splits the grid in two
+  for (int y = 0; y < 5; y++) {
+    occupy(state, {2, y}, 1);
+  }
+  spatial::DistanceField field;
+  field.compute(state, {0, 0});
+  EXPECT_EQ(spatial::DistanceField::unreachable, field.distanceTo({4, 0}));
+  EXPECT_EQ(spatial::DistanceField::unreachable, field.distanceTo({2, 2}));
+  // Two columns of five cells on our side of the wall
+  EXPECT_EQ(10, field.reachableCount());
+  EXPECT_EQ(10, spatial::territorySize(state, {0, 0}));
+}
+
+TEST(SpatialTest, OccupiedSourceStillFloods) {
+  auto state = makeState(3, 3);
+  // The source is our own head: occupied, but the flood starts there
+  occupy(state, {1, 1}, 7);
+  spatial::DistanceField field;
+  field.compute(state, {1, 1});
+  EXPECT_EQ(0, field.distanceTo({1, 1}));
+  EXPECT_EQ(1, field.distanceTo({0, 1}));
+  EXPECT_EQ(9, field.reachableCount());
+}
+
+TEST(SpatialTest, WindowedStateIndexesRelativeToOffset) {
+  // A 4x3 window starting at (10, 20), as an interest-managed server sends
+  auto state = makeState(4, 3, {10, 20});
+  state.gridWidth = 100;
+  state.gridHeight = 100;
+  occupy(state, {12, 21}, 3);
+  spatial::DistanceField field;
+  field.compute(state, {10, 20});
+  EXPECT_EQ(0, field.distanceTo({10, 20}));
+  EXPECT_EQ(3, field.distanceTo({13, 20}));
+  EXPECT_EQ(spatial::DistanceField::unreachable, field.distanceTo({12, 21}));
+  EXPECT_EQ(11, field.reachableCount()); // 12 window cells minus the wall
+}
+
+} // namespace